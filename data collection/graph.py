@@ -1,36 +1,49 @@
 # graph.py
-import re
+import argparse, os, re, sys
 import matplotlib.pyplot as plt
 
-# === Read file ===
-with open("data.txt", "r") as f:   # adjust path if needed
-    lines = f.readlines()
+parser = argparse.ArgumentParser()
+parser.add_argument("path", nargs="?", default="data.txt", help="Serial log or .fses session store")
+parser.add_argument("--session", default="0", help="Session name or number inside a store")
+args = parser.parse_args()
 
 # === Extract data ===
-thumb, index, middle, ring, pinky = [], [], [], [], []
-gyro_x, gyro_y, gyro_z = [], [], []
-
-pattern = re.compile(
-    r"Thumb:(\d+) \| Index:(\d+) \| Middle:(\d+) \| Ring:(\d+) \| Pinky:(\d+).*Gyro X:([-]?\d+) Y:([-]?\d+) Z:([-]?\d+)"
-)
-
-for line in lines:
-    match = pattern.search(line)
-    if match:
-        t, i, m, r, p, gx, gy, gz = map(int, match.groups())
-        thumb.append(t)
-        index.append(i)
-        middle.append(m)
-        ring.append(r)
-        pinky.append(p)
-        gyro_x.append(gx)
-        gyro_y.append(gy)
-        gyro_z.append(gz)
+if args.path.endswith(".fses"):
+    # Plot straight from the memory-mapped columns
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "ml"))
+    import session_store as ss
+    store = ss.SessionStore(args.path)
+    s = store.session(int(args.session) if args.session.isdigit() else args.session)
+    thumb, index, middle, ring, pinky = (s[c] for c in ss.FLEX)
+    gyro_x, gyro_y, gyro_z = (s[c] for c in ss.GYRO)
+else:
+    with open(args.path, "r") as f:
+        lines = f.readlines()
+
+    thumb, index, middle, ring, pinky = [], [], [], [], []
+    gyro_x, gyro_y, gyro_z = [], [], []
+
+    pattern = re.compile(
+        r"Thumb:(\d+) \| Index:(\d+) \| Middle:(\d+) \| Ring:(\d+) \| Pinky:(\d+).*Gyro X:([-]?\d+) Y:([-]?\d+) Z:([-]?\d+)"
+    )
+
+    for line in lines:
+        match = pattern.search(line)
+        if match:
+            t, i, m, r, p, gx, gy, gz = map(int, match.groups())
+            thumb.append(t)
+            index.append(i)
+            middle.append(m)
+            ring.append(r)
+            pinky.append(p)
+            gyro_x.append(gx)
+            gyro_y.append(gy)
+            gyro_z.append(gz)
 
 print(f"Parsed {len(thumb)} samples.")
 
 if len(thumb) == 0:
-    print("⚠️ No data matched the pattern. Check your data.txt format.")
+    print(f"⚠️ No data matched the pattern. Check the format of {args.path}.")
     exit()
 
 # === Plot ===
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio.h"
+
+// Layer III bitrates in kbit/s: MPEG-1, then MPEG-2/2.5
+static const uint16_t bitrate_l3[2][16] = {
+    { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+};
+static const uint32_t sample_rate[3] = { 44100, 48000, 32000 };
+
+// Length and sample count of the Layer III frame starting at p, 0 if not a frame header
+static int frame_info(const uint8_t *p, int *samples, uint32_t *rate) {
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return 0;
+    int version = (p[1] >> 3) & 3;      // 0 = 2.5, 2 = 2, 3 = 1
+    int layer = (p[1] >> 1) & 3;        // 1 = Layer III
+    int br_idx = p[2] >> 4, sr_idx = (p[2] >> 2) & 3, pad = (p[2] >> 1) & 1;
+    if (version == 1 || layer != 1 || br_idx == 0 || br_idx == 15 || sr_idx == 3) return 0;
+
+    int mpeg1 = version == 3;
+    uint32_t sr = sample_rate[sr_idx] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+    uint32_t br = bitrate_l3[!mpeg1][br_idx] * 1000u;
+    *samples = mpeg1 ? 1152 : 576;
+    *rate = sr;
+    return (int)((mpeg1 ? 144 : 72) * br / sr) + pad;
+}
+
+int audio_mp3_duration_ms(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = malloc(size > 0 ? size : 1);
+    size_t len = fread(buf, 1, size, fp);
+    fclose(fp);
+
+    // Skip an ID3v2 tag (syncsafe size)
+    size_t pos = 0;
+    if (len >= 10 && !memcmp(buf, "ID3", 3)) {
+        pos = 10 + ((buf[6] & 0x7F) << 21 | (buf[7] & 0x7F) << 14 | (buf[8] & 0x7F) << 7 | (buf[9] & 0x7F));
+    }
+
+    // Walk every frame so VBR files without a Xing header come out right too
+    double seconds = 0;
+    int frames = 0;
+    while (pos + 4 <= len) {
+        int samples;
+        uint32_t rate;
+        int flen = frame_info(&buf[pos], &samples, &rate);
+        if (flen < 4) {
+            pos++;
+            continue;
+        }
+        seconds += (double)samples / rate;
+        frames++;
+        pos += flen;
+    }
+    free(buf);
+    return frames ? (int)(seconds * 1000 + 0.5) : -1;
+}
+
+int audio_load_durations(const char *dir, uint32_t ms[AUDIO_MAX_TRACKS]) {
+    char path[512];
+    int found = 0;
+
+    memset(ms, 0, AUDIO_MAX_TRACKS * sizeof(ms[0]));
+    for (int t = 1; t < AUDIO_MAX_TRACKS; t++) {
+        snprintf(path, sizeof(path), "%s/%04d.mp3", dir, t);
+        int d = audio_mp3_duration_ms(path);
+        if (d < 0) continue;
+        ms[t] = d;
+        found++;
+    }
+    return found;
+}
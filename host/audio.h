@@ -0,0 +1,13 @@
+// Clip lengths of the SD card audio, read from the MP3 frame headers
+
+#pragma once
+
+#include <stdint.h>
+
+#define AUDIO_MAX_TRACKS 256
+
+// Play time of one MP3 file in ms, -1 if it cannot be read
+int audio_mp3_duration_ms(const char *path);
+
+// ms[track] for every NNNN.mp3 in dir (0 when missing); returns the number of files found
+int audio_load_durations(const char *dir, uint32_t ms[AUDIO_MAX_TRACKS]);
@@ -0,0 +1,775 @@
+// Host benchmark for the recognition pipeline: kernel microbenchmarks plus
+// end-to-end replay of recorded and synthetic sessions, of a synthetic session
+// with one broken flex sensor, and of every session under the sampling
+// governor, results as JSON.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "audio.h"
+#include "builtin_vocab.h"
+#include "dfplayer.h"
+#include "dfplayer_emu.h"
+#include "flex_filter.h"
+#include "flex_health.h"
+#include "gesture.h"
+#include "governor.h"
+#include "model_blob.h"
+#include "recorder.h"
+#include "replay.h"
+#include "session.h"
+
+#define SAMPLES 20          // Oversampling of the old get_smoothed_adc_value()
+#define FLEX_ADC_BLOCK 64   // frames per flex_filter_block() call in the quality run
+#define DEGRADED_FRAMES 20000   // synthetic session each sensor fault is replayed on
+#define RECORDER_FRAMES 512     // CONFIG_FLEXSONIC_RECORDER_FRAMES default
+
+// Same filter settings as flexsonic.c
+static const flex_filter_cfg_t filter_cfg = FLEX_FILTER_DEFAULTS;
+
+#ifndef FLEXSONIC_ROOT
+#define FLEXSONIC_ROOT ".."
+#endif
+
+typedef struct {
+    const char *model_path;
+    const char *json_path;
+    long iterations;
+    size_t synth_frames;
+    uint32_t seed;
+} bench_args_t;
+
+static volatile int sink;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng_next(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+static uint16_t clamp_adc(int v) {
+    return v < 0 ? 0 : v > 4095 ? 4095 : v;
+}
+
+// ------------------- MODELS -------------------
+// Labels of gesture_labeled.csv mapped to the tracks of 3_predict_and_audio.py,
+// with the firmware's built-in acceptance threshold
+#define LABEL_MIN_CONF 350
+
+static const model_rule_t label_rules[] = {
+    { .track = 6, .flex_mask = FINGER_THUMB | FINGER_MIDDLE | FINGER_RING | FINGER_PINKY, .flex_lo = 1000, .flex_hi = 4095, .min_conf = LABEL_MIN_CONF },
+    { .track = 2, .flex_mask = FINGER_INDEX,  .flex_lo = 1000, .flex_hi = 4095, .min_conf = LABEL_MIN_CONF },
+    { .track = 1, .flex_mask = FINGER_THUMB,  .flex_lo = 1000, .flex_hi = 4095, .min_conf = LABEL_MIN_CONF },
+    { .track = 3, .flex_mask = FINGER_MIDDLE, .flex_lo = 1000, .flex_hi = 4095, .min_conf = LABEL_MIN_CONF },
+    { .track = 4, .flex_mask = FINGER_RING,   .flex_lo = 1000, .flex_hi = 4095, .min_conf = LABEL_MIN_CONF },
+    { .track = 5, .flex_mask = FINGER_PINKY,  .flex_lo = 1000, .flex_hi = 4095, .min_conf = LABEL_MIN_CONF },
+};
+
+// Built-in vocabulary of flexsonic.c, for the decision cases; read in place like the firmware does
+static const model_blob_header_t sentence_header = {
+    .n_features = NUM_FLEX,
+    .n_rules = sizeof(builtin_rules) / sizeof(builtin_rules[0]),
+};
+
+static const model_blob_view_t sentence_model = {
+    .header = &sentence_header,
+    .rules = builtin_rules,
+};
+
+// Centroid-only model with the same classes, for the classifier microbenchmark
+static const float centroid_table[6][NUM_FLEX] = {
+    { 2.2f, 0, 0, 0, 0 }, { 0, 2.25f, 0, 0, 0 }, { 0, 0, 2.85f, 0, 0 },
+    { 0, 0, 0, 3.3f, 0 }, { 0, 0, 0, 0.6f, 2.2f }, { 3.0f, 2.0f, 3.6f, 4.0f, 4.0f },
+};
+
+// Synthetic test blob in the model_blob.h layout; real vocabularies come from ml/5_export_model_blob.py
+static void *build_blob(const model_rule_t *rules, int n_rules, const float (*centroids)[NUM_FLEX],
+                        int n_clusters, size_t *len) {
+    size_t size = model_blob_size(NUM_FLEX, n_clusters, n_rules);
+    uint8_t *blob = aligned_alloc(4, (size + 3) & ~(size_t)3);
+    model_blob_header_t *h = (model_blob_header_t *)blob;
+    float *p = (float *)(blob + sizeof(*h));
+
+    memset(blob, 0, size);
+    for (int j = 0; j < NUM_FLEX; j++) *p++ = 0.0f;       // scaler mean
+    for (int j = 0; j < NUM_FLEX; j++) *p++ = 1000.0f;    // scaler scale
+    for (int c = 0; c < n_clusters; c++) {
+        for (int j = 0; j < NUM_FLEX; j++) *p++ = centroids[c][j];
+    }
+    p += n_clusters;                                         // cluster radius, unbounded
+    uint16_t *tracks = (uint16_t *)p;
+    for (int c = 0; c < n_clusters; c++) {
+        tracks[c] = c + 1;
+        tracks[n_clusters + c] = LABEL_MIN_CONF;             // cluster_min_conf
+    }
+    if (n_rules) memcpy(blob + size - n_rules * sizeof(model_rule_t), rules, n_rules * sizeof(model_rule_t));
+
+    h->magic = MODEL_BLOB_MAGIC;
+    h->version = MODEL_BLOB_VERSION;
+    h->header_size = sizeof(*h);
+    h->generation = 1;
+    h->payload_size = size - sizeof(*h);
+    h->payload_crc32 = model_blob_crc32(0, blob + sizeof(*h), h->payload_size);
+    h->n_features = NUM_FLEX;
+    h->n_clusters = n_clusters;
+    h->n_rules = n_rules;
+    h->header_crc32 = model_blob_crc32(0, h, offsetof(model_blob_header_t, header_crc32));
+    *len = size;
+    return blob;
+}
+
+// ------------------- MICROBENCHMARKS -------------------
+typedef struct {
+    const char *name;
+    double ns_per_op;
+} micro_result_t;
+
+static double micro_boxcar(long iters) {
+    uint16_t samples[SAMPLES];
+    for (int i = 0; i < SAMPLES; i++) samples[i] = rng_next() & 0xFFF;
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < iters; k++) {
+        samples[k % SAMPLES] ^= 1;
+        sink = flex_boxcar(samples, SAMPLES, 1);
+    }
+    return (double)(now_ns() - t0) / iters;
+}
+
+static double micro_filter_bank(long iters) {
+    enum { BLOCK = 64 };
+    uint16_t in[BLOCK * FLEX_CHANNELS], out[BLOCK * FLEX_CHANNELS];
+    flex_filter_t f;
+
+    flex_filter_init(&f, &filter_cfg);
+    for (int i = 0; i < BLOCK * FLEX_CHANNELS; i++) in[i] = rng_next() & 0xFFF;
+    long blocks = iters / BLOCK + 1;
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < blocks; k++) {
+        in[k % (BLOCK * FLEX_CHANNELS)] ^= 1;
+        sink = flex_filter_block(&f, in, BLOCK, out) + out[0];
+    }
+    return (double)(now_ns() - t0) / (blocks * BLOCK);
+}
+
+static double micro_health(long iters) {
+    enum { BLOCK = 128 };   // FLEX_ADC_MAX_FRAMES
+    uint16_t in[BLOCK * FLEX_CHANNELS];
+    flex_health_t h;
+
+    flex_health_init(&h);
+    for (int i = 0; i < BLOCK * FLEX_CHANNELS; i++) in[i] = 2000 + (rng_next() & 0x3F);
+    long blocks = iters / BLOCK + 1;
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < blocks; k++) {
+        in[k % (BLOCK * FLEX_CHANNELS)] ^= 1;
+        sink = flex_health_block(&h, in, BLOCK) + h.ch[0].sd;
+    }
+    return (double)(now_ns() - t0) / (blocks * BLOCK);
+}
+
+static double micro_features(const model_blob_view_t *m, long iters) {
+    gesture_frame_t f = { { 1200, 0, 40, 3000, 0 }, { 0, 0, 0 }, 0 };
+    float x[MODEL_MAX_FEATURES];
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < iters; k++) {
+        f.flex[k % NUM_FLEX] ^= 1;
+        gesture_scale_features(m, &f, x);
+        sink = (int)x[0];
+    }
+    return (double)(now_ns() - t0) / iters;
+}
+
+static double micro_classify(const model_blob_view_t *m, long iters) {
+    gesture_frame_t f = { { 0, 0, 0, 0, 0 }, { 0, 0, 0 }, 0 };
+    gesture_result_t r;
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < iters; k++) {
+        f.flex[k % NUM_FLEX] = (k * 977) & 0xFFF;
+        gesture_classify(m, &f, &r);
+        sink = r.track;
+    }
+    return (double)(now_ns() - t0) / iters;
+}
+
+static double micro_dfplayer(long iters) {
+    uint8_t packet[DFPLAYER_FRAME_LEN];
+    dfplayer_frame_t frame;
+    bool valid;
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < iters; k++) {
+        dfplayer_build_frame(packet, CMD_PLAY_TRACK, (uint16_t)k, false);
+        sink = (int)dfplayer_parse_frame(packet, sizeof(packet), &frame, &valid) + frame.param;
+    }
+    return (double)(now_ns() - t0) / iters;
+}
+
+// One frame into the flight recorder, as the frame loop does every frame
+static double micro_recorder(long iters) {
+    static recorder_frame_t ring[RECORDER_FRAMES];
+    recorder_t r;
+    recorder_frame_t f = { .track = GESTURE_REST };
+    recorder_init(&r, ring, RECORDER_FRAMES);
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < iters; k++) {
+        f.t_ms = (uint32_t)k;
+        f.flex[k % NUM_FLEX] = (int16_t)k;
+        recorder_push(&r, &f);
+    }
+    sink = ring[iters & (RECORDER_FRAMES - 1)].flex[0];
+    return (double)(now_ns() - t0) / iters;
+}
+
+// ------------------- DECISION CASES -------------------
+// Short scripted frame sequences with a known number of plays
+typedef struct {
+    const char *name;
+    int flex;                 // every finger
+    int n;
+    int16_t gyro_x[16];
+    int expected;
+} decision_case_t;
+
+typedef struct {
+    const char *name;
+    int plays, expected;
+} decision_result_t;
+
+static const decision_case_t decision_cases[] = {
+    // Wrist jitter across the gyro threshold, never back below the re-arm level: one play
+    { "gyro_jitter", 300, 12, { 1800, 900, 1800, 900, 1800, 700, 1800, 900, 1800, 650, 1800, 900 }, 1 },
+    // Calm below 600 in between: plays again
+    { "gyro_rearm", 300, 5, { 1800, 900, 1800, 400, 1800 }, 2 },
+    // Open hand (no flex reading) swinging the wrist: gyro rules still fire
+    { "gyro_open_hand", 0, 5, { 1800, 1800, 1800, 400, 400 }, 1 },
+};
+#define N_DECISION_CASES (int)(sizeof(decision_cases) / sizeof(decision_cases[0]))
+
+static void decision_checks(const model_blob_view_t *m, decision_result_t *out) {
+    for (int i = 0; i < N_DECISION_CASES; i++) {
+        const decision_case_t *c = &decision_cases[i];
+        gesture_state_t state = { 0 };
+        gesture_frame_t f = { 0 };
+        out[i] = (decision_result_t){ c->name, 0, c->expected };
+        for (int k = 0; k < NUM_FLEX; k++) f.flex[k] = c->flex;
+        for (int k = 0; k < c->n; k++) {
+            f.gyro[0] = c->gyro_x[k];
+            if (gesture_decide(m, &f, &state, NULL)) out[i].plays++;
+        }
+        fprintf(stderr, "%-30s %d plays (expected %d)%s\n", c->name, out[i].plays, c->expected,
+                out[i].plays == c->expected ? "" : "  MISMATCH");
+    }
+}
+
+// ------------------- RECORDER REPLAY -------------------
+// A dump must replay to the decisions the glove recorded. Frames are decided
+// and recorded here as the frame loop does, the middle finger shorted and
+// marked dead for the newest half of the ring, then dumped and replayed.
+typedef struct {
+    const char *name;
+    size_t frames, degraded, mismatches;
+    size_t mismatches_live;   // same dump with the dead mask dropped: the check can fail
+} recorder_replay_t;
+
+static void recorder_replay(const session_t *src, const model_blob_view_t *m, const char *name,
+                            recorder_replay_t *out) {
+    static recorder_frame_t ring[RECORDER_FRAMES];
+    static uint8_t dump[sizeof(recorder_dump_header_t) + RECORDER_FRAMES * sizeof(recorder_frame_t)];
+    recorder_t rec;
+    gesture_state_t state = { 0 };
+    gesture_result_t res;
+    gesture_frame_t f = { { 0 }, { 0 }, 0 };
+
+    recorder_init(&rec, ring, RECORDER_FRAMES);
+    for (size_t k = 0; k < src->n; k++) {
+        const session_frame_t *sf = &src->frames[k];
+        for (int i = 0; i < NUM_FLEX; i++) f.flex[i] = sf->flex[i];
+        memcpy(f.gyro, sf->gyro, sizeof(f.gyro));
+        f.dead_mask = k + RECORDER_FRAMES / 2 >= src->n ? FINGER_MIDDLE : 0;
+        if (f.dead_mask) f.flex[2] = 4095;
+        int track = gesture_decide(m, &f, &state, &res);
+
+        recorder_frame_t rf = {
+            .t_ms = (uint32_t)(k * REPLAY_FRAME_MS), .track = res.track, .candidate = res.candidate,
+            .played = track, .confidence = (uint8_t)(res.confidence * 100), .stage = res.stage,
+            .dead_mask = f.dead_mask, .level = GOVERNOR_READY,
+        };
+        for (int i = 0; i < NUM_FLEX; i++) rf.flex[i] = f.flex[i];
+        memcpy(rf.gyro, f.gyro, sizeof(rf.gyro));
+        if (k + 1 == src->n) recorder_trigger(&rec, RECORDER_TRIGGER_CONSOLE);
+        recorder_push(&rec, &rf);
+    }
+
+    // Laid out as the dump task saves it
+    const recorder_frame_t *run[2];
+    uint32_t n[2] = { 0, 0 };
+    recorder_dump_header_t *h = (recorder_dump_header_t *)dump;
+    int runs = recorder_runs(&rec, run, n);
+    recorder_header(&rec, 1, h);
+    size_t len = sizeof(*h);
+    for (int i = 0; i < runs; i++) {
+        memcpy(dump + len, run[i], n[i] * sizeof(recorder_frame_t));
+        len += n[i] * sizeof(recorder_frame_t);
+    }
+
+    session_t s = { 0 };
+    replay_cfg_t cfg = { .seed = 1 };
+    replay_result_t r;
+    *out = (recorder_replay_t){ name, 0, 0, 0, 0 };
+    if (session_load_dump(&s, dump, len, name) != 0) {
+        out->mismatches = SIZE_MAX;
+        return;
+    }
+    replay_session(&s, m, &cfg, &r);
+    out->frames = r.frames;
+    out->degraded = r.degraded;
+    out->mismatches = r.mismatches;
+    for (size_t k = 0; k < s.n; k++) s.frames[k].dead_mask = 0;
+    replay_session(&s, m, &cfg, &r);
+    out->mismatches_live = r.mismatches;
+    session_free(&s);
+    fprintf(stderr, "%-30s %zu frames, %zu degraded: %zu decided differently (%zu without the dead mask)%s\n",
+            name, out->frames, out->degraded, out->mismatches, out->mismatches_live,
+            out->mismatches ? "  MISMATCH" : "");
+}
+
+// ------------------- FILTER QUALITY -------------------
+typedef struct {
+    const char *name;
+    double rmse;
+    double max_err;
+    double ns_per_frame;   // per 5-finger output frame
+} filter_result_t;
+
+#define QUALITY_FRAMES 200000
+
+// Ramps between rest and full bend with ADC noise and the 0 <-> 1000s jumps seen in data.txt
+static void quality_stream(uint16_t *raw, uint16_t *truth, int n_frames) {
+    for (int k = 0; k < n_frames; k++) {
+        for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+            int phase = (k + ch * 700) % 4000;
+            int t = phase < 1800 ? 0 : phase < 2000 ? (phase - 1800) * 3500 / 200
+                  : phase < 3800 ? 3500 : 3500 - (phase - 3800) * 3500 / 200;
+            int noise = (int)(rng_next() % 81) + (int)(rng_next() % 81) - 80;
+            int v = t + noise;
+            if (rng_next() % 200 == 0) v = rng_next() % 2 ? 1000 + (int)(rng_next() % 3096) : 0;
+            truth[k * FLEX_CHANNELS + ch] = t;
+            raw[k * FLEX_CHANNELS + ch] = clamp_adc(v);
+        }
+    }
+}
+
+static void quality_score(filter_result_t *r, double sq, double max_err, size_t n) {
+    r->rmse = n ? sqrt(sq / n) : 0;
+    r->max_err = max_err;
+}
+
+static void filter_quality(filter_result_t res[2]) {
+    uint16_t *raw = malloc(QUALITY_FRAMES * FLEX_CHANNELS * sizeof(uint16_t));
+    uint16_t *truth = malloc(QUALITY_FRAMES * FLEX_CHANNELS * sizeof(uint16_t));
+    uint16_t *out = malloc(QUALITY_FRAMES * FLEX_CHANNELS * sizeof(uint16_t));
+    double sq = 0, max_err = 0;
+    size_t n = 0;
+
+    quality_stream(raw, truth, QUALITY_FRAMES);
+
+    // Old path: boxcar over SAMPLES reads of each finger
+    int n_win = QUALITY_FRAMES / SAMPLES;
+    uint64_t t0 = now_ns();
+    for (int w = 0; w < n_win; w++) {
+        for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+            out[w * FLEX_CHANNELS + ch] = flex_boxcar(&raw[w * SAMPLES * FLEX_CHANNELS + ch], SAMPLES, FLEX_CHANNELS);
+        }
+    }
+    res[0].name = "boxcar_20";
+    res[0].ns_per_frame = (double)(now_ns() - t0) / n_win;
+    for (int w = 0; w < n_win; w++) {
+        for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+            double e = fabs((double)out[w * FLEX_CHANNELS + ch] - truth[((w + 1) * SAMPLES - 1) * FLEX_CHANNELS + ch]);
+            sq += e * e;
+            if (e > max_err) max_err = e;
+            n++;
+        }
+    }
+    quality_score(&res[0], sq, max_err, n);
+
+    // New path: filter bank over whole DMA blocks
+    flex_filter_t f;
+    flex_filter_init(&f, &filter_cfg);
+    int n_out = 0;
+    t0 = now_ns();
+    for (int k = 0; k < QUALITY_FRAMES; k += FLEX_ADC_BLOCK) {
+        n_out += flex_filter_block(&f, &raw[k * FLEX_CHANNELS], FLEX_ADC_BLOCK, &out[n_out * FLEX_CHANNELS]);
+    }
+    res[1].name = "filter_bank";
+    res[1].ns_per_frame = n_out ? (double)(now_ns() - t0) / n_out : 0;
+    sq = max_err = 0;
+    n = 0;
+    for (int o = 0; o < n_out; o++) {
+        for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+            double e = fabs((double)out[o * FLEX_CHANNELS + ch] - truth[((o + 1) * filter_cfg.decimation - 1) * FLEX_CHANNELS + ch]);
+            sq += e * e;
+            if (e > max_err) max_err = e;
+            n++;
+        }
+    }
+    quality_score(&res[1], sq, max_err, n);
+
+    free(raw);
+    free(truth);
+    free(out);
+}
+
+// ------------------- DEGRADED MODE -------------------
+// One sensor fails a tenth into the session; replayed with and without the
+// health monitor's dead mask
+typedef struct {
+    char name[48];
+    replay_result_t on, off;
+    replay_result_t healthy;   // same frames scored with the finger still working
+} degraded_result_t;
+
+static const struct {
+    const char *name;
+    uint8_t kind;
+    uint16_t value;
+} degraded_faults[] = {
+    { "zero", REPLAY_FAULT_STUCK, 0 },        // disconnected
+    { "stuck", REPLAY_FAULT_STUCK, 2000 },    // mid-scale, reads as half bent
+    { "rail", REPLAY_FAULT_STUCK, 4095 },     // shorted to the supply
+    { "noise", REPLAY_FAULT_NOISE, 0 },       // open input
+};
+
+#define N_DEGRADED (FLEX_CHANNELS * (int)(sizeof(degraded_faults) / sizeof(degraded_faults[0])))
+
+static void degraded_mode(const session_t *s, const model_blob_view_t *m, const char *model_name,
+                          uint32_t seed, degraded_result_t *out) {
+    int n = 0;
+    for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+        for (size_t k = 0; k < sizeof(degraded_faults) / sizeof(degraded_faults[0]); k++) {
+            replay_fault_t fault = {
+                .channel = ch, .kind = degraded_faults[k].kind, .value = degraded_faults[k].value,
+                .from_ms = s->n * REPLAY_FRAME_MS / 10.0,
+            };
+            replay_cfg_t cfg = { .seed = seed, .faults = &fault, .n_faults = 1 };
+            degraded_result_t *d = &out[n++];
+            snprintf(d->name, sizeof(d->name), "%s:%s%s", flex_channel_names[ch], degraded_faults[k].name, model_name);
+            replay_session(s, m, &cfg, &d->on);
+            cfg.no_health = true;
+            replay_session(s, m, &cfg, &d->off);
+            fault.kind = REPLAY_FAULT_NONE;
+            replay_session(s, m, &cfg, &d->healthy);
+        }
+    }
+}
+
+static double spared_accuracy(const replay_result_t *r) {
+    return r->spared_labelled ? (double)r->spared_correct / r->spared_labelled : 0.0;
+}
+
+static double false_rate(const replay_result_t *r) {
+    return r->scored_plays ? (double)r->false_plays / r->scored_plays : 0.0;
+}
+
+static void degraded_summary(const degraded_result_t *d, int n, const char *model_name) {
+    double acc_on = 0, acc_off = 0, acc_healthy = 0, fr_on = 0, fr_off = 0;
+    for (int i = 0; i < n; i++) {
+        acc_on += spared_accuracy(&d[i].on);
+        acc_off += spared_accuracy(&d[i].off);
+        acc_healthy += spared_accuracy(&d[i].healthy);
+        fr_on += false_rate(&d[i].on);
+        fr_off += false_rate(&d[i].off);
+    }
+    fprintf(stderr, "%-30s %d faults  accuracy on the other fingers %5.1f%% (%5.1f%% without, %5.1f%% healthy)  "
+            "false triggers %5.1f%% (%5.1f%% without)\n", model_name, n,
+            100 * acc_on / n, 100 * acc_off / n, 100 * acc_healthy / n, 100 * fr_on / n, 100 * fr_off / n);
+}
+
+// ------------------- SAMPLING GOVERNOR -------------------
+// Each session at the fixed 300 ms period and at the governor's rate, both
+// through the DFPlayer emulator
+typedef struct {
+    replay_result_t fixed, governed;
+} governor_result_t;
+
+static void governor_run(const session_t *s, const model_blob_view_t *m, replay_cfg_t cfg,
+                         const dfplayer_emu_cfg_t *player_cfg, governor_result_t *out) {
+    static const governor_cfg_t governor_cfg = GOVERNOR_DEFAULTS;
+    dfplayer_emu_t player;
+
+    cfg.player = &player;
+    dfplayer_emu_init(&player, player_cfg, -player_cfg->boot_ms);
+    replay_session(s, m, &cfg, &out->fixed);
+    dfplayer_emu_free(&player);
+
+    cfg.governor = &governor_cfg;
+    dfplayer_emu_init(&player, player_cfg, -player_cfg->boot_ms);
+    replay_session(s, m, &cfg, &out->governed);
+    dfplayer_emu_free(&player);
+}
+
+static double decision_ms(const replay_result_t *r) {
+    return r->detected ? r->decision_ms / r->detected : 0.0;
+}
+
+static double frames_per_s(const replay_result_t *r) {
+    return r->session_ms > 0 ? r->sampled * 1000 / r->session_ms : 0.0;
+}
+
+static double adc_on_share(const replay_result_t *r) {
+    return r->session_ms > 0 ? r->adc_on_ms / r->session_ms : 0.0;
+}
+
+static void governor_summary(const governor_result_t *g) {
+    const replay_result_t *a = &g->fixed, *b = &g->governed;
+    fprintf(stderr, "%-30s decision %4.0f -> %4.0f ms  false %5.1f%% -> %5.1f%%  %4.2f -> %4.2f frames/s  "
+            "adc on %3.0f%% -> %3.0f%%  rest %3.0f%% motion %3.0f%%\n", a->name,
+            decision_ms(a), decision_ms(b), 100 * false_rate(a), 100 * false_rate(b), frames_per_s(a), frames_per_s(b),
+            100 * adc_on_share(a), 100 * adc_on_share(b),
+            100.0 * b->governor.level_ms[GOVERNOR_REST] / (b->session_ms > 0 ? b->session_ms : 1),
+            100.0 * b->governor.level_ms[GOVERNOR_MOTION] / (b->session_ms > 0 ? b->session_ms : 1));
+}
+
+// ------------------- OUTPUT -------------------
+static void write_degraded(FILE *out, const char *key, const replay_result_t *r) {
+    fprintf(out, "\"%s\": {\"accuracy\": %.4f, \"spared_accuracy\": %.4f, \"false_trigger_rate\": %.4f, "
+            "\"plays\": %zu, \"degraded\": %zu}", key, r->labelled ? (double)r->correct / r->labelled : 0.0,
+            spared_accuracy(r), false_rate(r), r->plays, r->degraded);
+}
+
+static void write_governed(FILE *out, const char *key, const replay_result_t *r) {
+    fprintf(out, "\"%s\": {\"accuracy\": %.4f, \"false_trigger_rate\": %.4f, \"detected\": %zu, "
+            "\"decision_ms\": %.0f, \"decision_max_ms\": %.0f, \"frames_per_s\": %.2f, \"adc_on_share\": %.4f}",
+            key, r->labelled ? (double)r->correct / r->labelled : 0.0, false_rate(r), r->detected,
+            decision_ms(r), r->decision_max_ms, frames_per_s(r), adc_on_share(r));
+}
+
+static void write_json(FILE *out, const micro_result_t *micro, int n_micro,
+                       const filter_result_t *filt, int n_filt, const replay_result_t *rep, int n_rep,
+                       const degraded_result_t *deg, int n_deg, const governor_result_t *gov, int n_gov,
+                       const decision_result_t *dec, int n_dec, const recorder_replay_t *rec, int n_rec,
+                       size_t model_bytes, size_t session_bytes) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    fprintf(out, "{\n  \"version\": 1,\n  \"micro\": {\n");
+    for (int i = 0; i < n_micro; i++) {
+        fprintf(out, "    \"%s\": {\"ns_per_op\": %.2f}%s\n", micro[i].name, micro[i].ns_per_op,
+                i + 1 < n_micro ? "," : "");
+    }
+    fprintf(out, "  },\n  \"filter\": {\n");
+    for (int i = 0; i < n_filt; i++) {
+        fprintf(out, "    \"%s\": {\"rmse\": %.2f, \"max_err\": %.0f, \"ns_per_frame\": %.2f}%s\n",
+                filt[i].name, filt[i].rmse, filt[i].max_err, filt[i].ns_per_frame, i + 1 < n_filt ? "," : "");
+    }
+    fprintf(out, "  },\n  \"sessions\": [\n");
+    for (int i = 0; i < n_rep; i++) {
+        const replay_result_t *r = &rep[i];
+        fprintf(out, "    {\"name\": \"%s\", \"frames\": %zu, \"fps\": %.0f, "
+                "\"latency_ns\": {\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"max\": %.0f}, "
+                "\"labelled\": %zu, \"accuracy\": %.4f, \"plays\": %zu, \"rejected\": %zu, "
+                "\"false_trigger_rate\": %.4f, \"wasted_ms\": %.0f, "
+                "\"audio\": {\"dropped\": %zu, \"latency_ms\": %.1f, \"latency_max_ms\": %.1f, \"gap_ms\": %.1f}, ",
+                r->name, r->frames, r->fps, r->p50_ns, r->p90_ns, r->p99_ns, r->max_ns,
+                r->labelled, r->labelled ? (double)r->correct / r->labelled : 0.0, r->plays, r->rejected,
+                r->scored_plays ? (double)r->false_plays / r->scored_plays : 0.0, r->wasted_ms,
+                r->audio.dropped, r->audio.started ? r->audio.latency_ms / r->audio.started : 0.0,
+                r->audio.latency_max_ms, r->audio.gaps ? r->audio.gap_ms / r->audio.gaps : 0.0);
+        fprintf(out, "\"cascade\": {");
+        for (int k = 0; k < GESTURE_STAGES; k++) {
+            size_t n = r->stage_hits[k];
+            fprintf(out, "%s\"%s\": {\"hit_rate\": %.4f, \"ns\": %.1f}", k ? ", " : "", replay_stage_names[k],
+                    r->sampled ? (double)n / r->sampled : 0.0, n ? r->stage_ns[k] / n : 0.0);
+        }
+        fprintf(out, "}}%s\n", i + 1 < n_rep ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"degraded\": [\n");
+    for (int i = 0; i < n_deg; i++) {
+        fprintf(out, "    {\"name\": \"%s\", ", deg[i].name);
+        write_degraded(out, "health", &deg[i].on);
+        fprintf(out, ", ");
+        write_degraded(out, "no_health", &deg[i].off);
+        fprintf(out, ", ");
+        write_degraded(out, "healthy", &deg[i].healthy);
+        fprintf(out, "}%s\n", i + 1 < n_deg ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"governor\": [\n");
+    for (int i = 0; i < n_gov; i++) {
+        fprintf(out, "    {\"name\": \"%s\", ", gov[i].fixed.name);
+        write_governed(out, "fixed", &gov[i].fixed);
+        fprintf(out, ", ");
+        write_governed(out, "governed", &gov[i].governed);
+        fprintf(out, "}%s\n", i + 1 < n_gov ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"decisions\": [\n");
+    for (int i = 0; i < n_dec; i++) {
+        fprintf(out, "    {\"name\": \"%s\", \"plays\": %d, \"expected\": %d}%s\n", dec[i].name, dec[i].plays,
+                dec[i].expected, i + 1 < n_dec ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"recorder_replay\": [\n");
+    for (int i = 0; i < n_rec; i++) {
+        fprintf(out, "    {\"name\": \"%s\", \"frames\": %zu, \"degraded\": %zu, \"mismatches\": %zu, "
+                "\"mismatches_without_dead_mask\": %zu}%s\n", rec[i].name, rec[i].frames, rec[i].degraded,
+                rec[i].mismatches, rec[i].mismatches_live, i + 1 < n_rec ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"footprint\": {\"model_bytes\": %zu, \"frame_state_bytes\": %zu, "
+            "\"recorder_bytes\": %zu, \"session_bytes\": %zu, \"peak_rss_kb\": %ld}\n}\n",
+            model_bytes, sizeof(gesture_frame_t) + sizeof(flex_filter_t) + sizeof(flex_health_t) + sizeof(governor_t)
+                + sizeof(gesture_state_t),
+            RECORDER_FRAMES * sizeof(recorder_frame_t) + sizeof(recorder_t), session_bytes, ru.ru_maxrss);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--model blob.bin] [--json out.json] [--iterations N] "
+            "[--synthetic-frames N] [--seed S]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    bench_args_t args = { .iterations = 2000000, .synth_frames = 200000, .seed = 42 };
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--model") && i + 1 < argc) args.model_path = argv[++i];
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc) args.json_path = argv[++i];
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) args.iterations = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--synthetic-frames") && i + 1 < argc) args.synth_frames = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) args.seed = strtoul(argv[++i], NULL, 10);
+        else usage(argv[0]);
+    }
+    rng_state = args.seed ? args.seed : 1;
+
+    size_t model_len, centroid_len;
+    void *blob = args.model_path ? replay_load_blob(args.model_path, &model_len)
+                                 : build_blob(label_rules, 6, NULL, 0, &model_len);
+    void *centroid_blob = build_blob(NULL, 0, centroid_table, 6, &centroid_len);
+    model_blob_view_t model, centroid_model;
+    if (!blob || !model_blob_parse(blob, model_len, &model)) {
+        fprintf(stderr, "invalid model blob %s\n", args.model_path);
+        return 1;
+    }
+    model_blob_parse(centroid_blob, centroid_len, &centroid_model);
+
+    micro_result_t micro[] = {
+        { "boxcar_20", micro_boxcar(args.iterations) },
+        { "filter_bank_frame", micro_filter_bank(args.iterations) },
+        { "health_frame", micro_health(args.iterations) },
+        { "scale_features", micro_features(&centroid_model, args.iterations) },
+        { "classify_rules", micro_classify(&model, args.iterations) },
+        { "classify_centroids", micro_classify(&centroid_model, args.iterations) },
+        { "dfplayer_frame", micro_dfplayer(args.iterations) },
+        { "recorder_push", micro_recorder(args.iterations) },
+    };
+
+    session_t sessions[3] = { 0 };
+    int n_sessions = 0;
+    if (session_load_log(&sessions[n_sessions], FLEXSONIC_ROOT "/data collection/data.txt") == 0) n_sessions++;
+    if (session_load_csv(&sessions[n_sessions], FLEXSONIC_ROOT "/data processed/gesture_labeled.csv") == 0) n_sessions++;
+    session_synth_cfg_t synth = {
+        .frames = args.synth_frames, .seed = args.seed, .noise = 60, .drift = 150, .spike_rate = 0.002,
+    };
+    session_synthesize(&sessions[n_sessions++], &synth);
+
+    // Plays go through the DFPlayer emulator with the real clip lengths
+    static uint32_t track_ms[AUDIO_MAX_TRACKS];
+    dfplayer_emu_cfg_t player_cfg = DFPLAYER_EMU_DEFAULTS;
+    if (audio_load_durations(FLEXSONIC_ROOT "/audio", track_ms)) {
+        player_cfg.track_ms = track_ms;
+        player_cfg.n_tracks = AUDIO_MAX_TRACKS;
+    }
+    dfplayer_emu_t player;
+
+    // Every session through the rule model, then through the centroid model to exercise the cascade
+    replay_result_t rep[6];
+    replay_cfg_t replay_cfg = { .track_ms = player_cfg.track_ms, .n_tracks = player_cfg.n_tracks,
+                                .seed = args.seed, .player = &player };
+    size_t session_bytes = 0;
+    int n_rep = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < n_sessions; i++) {
+            replay_result_t *r = &rep[n_rep++];
+            dfplayer_emu_init(&player, &player_cfg, -player_cfg.boot_ms);
+            replay_session(&sessions[i], pass ? &centroid_model : &model, &replay_cfg, r);
+            dfplayer_emu_free(&player);
+            if (pass) {
+                strncat(r->name, "+centroids", sizeof(r->name) - strlen(r->name) - 1);
+            } else {
+                session_bytes += sessions[i].n * sizeof(session_frame_t);
+            }
+            fprintf(stderr, "%-30s %8zu frames %10.0f fps  p99 %6.0f ns  accuracy %5.1f%% (%zu labelled)  "
+                    "%zu plays, %zu false\n",
+                    r->name, r->frames, r->fps, r->p99_ns,
+                    r->labelled ? 100.0 * r->correct / r->labelled : 0.0, r->labelled,
+                    r->plays, r->false_plays);
+            fprintf(stderr, "%-30s", "  cascade");
+            for (int k = 0; k < GESTURE_STAGES; k++) {
+                fprintf(stderr, "  %s %5.1f%% %5.0f ns", replay_stage_names[k],
+                        100.0 * r->stage_hits[k] / r->sampled,
+                        r->stage_hits[k] ? r->stage_ns[k] / r->stage_hits[k] : 0.0);
+            }
+            fputc('\n', stderr);
+        }
+    }
+    // Every sensor fault through both models
+    static degraded_result_t deg[2 * N_DEGRADED];
+    session_t degraded_session = { 0 };
+    session_synth_cfg_t degraded_synth = synth;
+    degraded_synth.frames = DEGRADED_FRAMES;
+    session_synthesize(&degraded_session, &degraded_synth);
+    degraded_mode(&degraded_session, &model, "", args.seed, deg);
+    degraded_mode(&degraded_session, &centroid_model, "+centroids", args.seed, deg + N_DEGRADED);
+    degraded_summary(deg, N_DEGRADED, "degraded mode");
+    degraded_summary(deg + N_DEGRADED, N_DEGRADED, "degraded mode+centroids");
+    session_free(&degraded_session);
+
+    // Every session under the governor, rule model
+    governor_result_t gov[3];
+    replay_cfg_t gov_cfg = { .track_ms = player_cfg.track_ms, .n_tracks = player_cfg.n_tracks, .seed = args.seed };
+    for (int i = 0; i < n_sessions; i++) {
+        governor_run(&sessions[i], &model, gov_cfg, &player_cfg, &gov[i]);
+        governor_summary(&gov[i]);
+    }
+
+    decision_result_t dec[N_DECISION_CASES];
+    decision_checks(&sentence_model, dec);
+
+    recorder_replay_t rec[2];
+    recorder_replay(&sessions[n_sessions - 1], &model, "recorder_dump", &rec[0]);
+    recorder_replay(&sessions[n_sessions - 1], &centroid_model, "recorder_dump+centroids", &rec[1]);
+
+    for (size_t i = 0; i < sizeof(micro) / sizeof(micro[0]); i++) {
+        fprintf(stderr, "%-24s %8.2f ns/op\n", micro[i].name, micro[i].ns_per_op);
+    }
+
+    filter_result_t filt[2];
+    filter_quality(filt);
+    for (int i = 0; i < 2; i++) {
+        fprintf(stderr, "%-24s rmse %6.1f  max err %5.0f  %7.2f ns/output frame\n",
+                filt[i].name, filt[i].rmse, filt[i].max_err, filt[i].ns_per_frame);
+    }
+
+    FILE *out = args.json_path ? fopen(args.json_path, "w") : stdout;
+    if (!out) {
+        perror(args.json_path);
+        return 1;
+    }
+    write_json(out, micro, sizeof(micro) / sizeof(micro[0]), filt, 2, rep, n_rep, deg, 2 * N_DEGRADED, gov, n_sessions,
+               dec, N_DECISION_CASES, rec, 2, model_len, session_bytes);
+    if (out != stdout) fclose(out);
+
+    for (int i = 0; i < n_sessions; i++) session_free(&sessions[i]);
+    free(blob);
+    free(centroid_blob);
+    return 0;
+}
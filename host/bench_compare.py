@@ -0,0 +1,112 @@
+import argparse, json, sys
+
+# Compare two flexsonic_bench JSON results and fail on regressions
+parser = argparse.ArgumentParser()
+parser.add_argument("baseline")
+parser.add_argument("current")
+parser.add_argument("--tolerance", type=float, default=0.10, help="Allowed relative slowdown")
+parser.add_argument("--accuracy_drop", type=float, default=0.005, help="Allowed absolute accuracy drop")
+parser.add_argument("--false_trigger_rise", type=float, default=0.01, help="Allowed absolute false trigger rate rise")
+parser.add_argument("--audio_ms", type=float, default=5, help="Allowed rise of emulated audio latency and gaps")
+parser.add_argument("--decision_ms", type=float, default=30, help="Allowed rise of mean gesture-to-play time")
+args = parser.parse_args()
+
+with open(args.baseline) as f:
+    base = json.load(f)
+with open(args.current) as f:
+    cur = json.load(f)
+
+regressions = []
+
+for name, b in base["micro"].items():
+    c = cur["micro"].get(name)
+    if c and c["ns_per_op"] > b["ns_per_op"] * (1 + args.tolerance):
+        regressions.append(f"{name}: {b['ns_per_op']:.2f} -> {c['ns_per_op']:.2f} ns/op")
+
+for name, b in base.get("filter", {}).items():
+    c = cur.get("filter", {}).get(name)
+    if c and c["rmse"] > b["rmse"] * (1 + args.tolerance):
+        regressions.append(f"{name}: rmse {b['rmse']:.1f} -> {c['rmse']:.1f}")
+
+cur_sessions = {s["name"]: s for s in cur["sessions"]}
+for b in base["sessions"]:
+    c = cur_sessions.get(b["name"])
+    if not c:
+        continue
+    if c["fps"] < b["fps"] * (1 - args.tolerance):
+        regressions.append(f"{b['name']}: {b['fps']:.0f} -> {c['fps']:.0f} fps")
+    if c["latency_ns"]["p99"] > b["latency_ns"]["p99"] * (1 + args.tolerance):
+        regressions.append(f"{b['name']}: p99 {b['latency_ns']['p99']:.0f} -> {c['latency_ns']['p99']:.0f} ns")
+    if b["labelled"] and c["accuracy"] < b["accuracy"] - args.accuracy_drop:
+        regressions.append(f"{b['name']}: accuracy {b['accuracy']:.4f} -> {c['accuracy']:.4f}")
+    if "false_trigger_rate" in b and c["false_trigger_rate"] > b["false_trigger_rate"] + args.false_trigger_rise:
+        regressions.append(f"{b['name']}: false triggers {b['false_trigger_rate']:.4f} -> {c['false_trigger_rate']:.4f}")
+    if "audio" in b and "audio" in c:
+        ba, ca = b["audio"], c["audio"]
+        if ca["latency_ms"] > ba["latency_ms"] + args.audio_ms:
+            regressions.append(f"{b['name']}: audio latency {ba['latency_ms']:.0f} -> {ca['latency_ms']:.0f} ms")
+        if ca["gap_ms"] > ba["gap_ms"] + args.audio_ms:
+            regressions.append(f"{b['name']}: audio gap {ba['gap_ms']:.0f} -> {ca['gap_ms']:.0f} ms")
+        if ca["dropped"] > ba["dropped"]:
+            regressions.append(f"{b['name']}: dropped DFPlayer commands {ba['dropped']} -> {ca['dropped']}")
+
+# Degraded mode: one broken sensor must not cost the gestures of the other fingers
+cur_degraded = {d["name"]: d["health"] for d in cur.get("degraded", [])}
+for d in base.get("degraded", []):
+    b, c = d["health"], cur_degraded.get(d["name"])
+    if not c:
+        continue
+    if c["spared_accuracy"] < b["spared_accuracy"] - args.accuracy_drop:
+        regressions.append(f"{d['name']}: accuracy on the other fingers {b['spared_accuracy']:.4f} -> {c['spared_accuracy']:.4f}")
+    if c["false_trigger_rate"] > b["false_trigger_rate"] + args.false_trigger_rise:
+        regressions.append(f"{d['name']}: false triggers {b['false_trigger_rate']:.4f} -> {c['false_trigger_rate']:.4f}")
+
+# ... nor fall below what the same frames score with the finger still working, for either model
+by_model = {}
+for d in cur.get("degraded", []):
+    if "healthy" not in d:
+        continue
+    by_model.setdefault("centroids" if d["name"].endswith("+centroids") else "rules", []).append(d)
+    c, h = d["health"], d["healthy"]
+    if c["spared_accuracy"] < h["spared_accuracy"] - args.accuracy_drop:
+        regressions.append(f"{d['name']}: accuracy on the other fingers {h['spared_accuracy']:.4f} healthy -> "
+                           f"{c['spared_accuracy']:.4f} degraded")
+for model, ds in by_model.items():
+    mean = lambda key, field: sum(d[key][field] for d in ds) / len(ds)
+    print(f"degraded {model}: accuracy on the other fingers {mean('health', 'spared_accuracy'):.3f} "
+          f"({mean('healthy', 'spared_accuracy'):.3f} healthy), false triggers {mean('health', 'false_trigger_rate'):.3f} "
+          f"({mean('healthy', 'false_trigger_rate'):.3f} healthy)")
+
+# Sampling governor: adapting the frame rate must keep decisions fast and plays right
+cur_governor = {g["name"]: g["governed"] for g in cur.get("governor", [])}
+for g in base.get("governor", []):
+    b, c = g["governed"], cur_governor.get(g["name"])
+    if not c:
+        continue
+    if c["decision_ms"] > b["decision_ms"] + args.decision_ms:
+        regressions.append(f"{g['name']}: governed decision time {b['decision_ms']:.0f} -> {c['decision_ms']:.0f} ms")
+    if c["false_trigger_rate"] > b["false_trigger_rate"] + args.false_trigger_rise:
+        regressions.append(f"{g['name']}: governed false triggers {b['false_trigger_rate']:.4f} -> {c['false_trigger_rate']:.4f}")
+
+# ... and never play wrong more often than the fixed period it replaces, whatever the baseline says
+for g in cur.get("governor", []):
+    f, c = g["fixed"], g["governed"]
+    if c["false_trigger_rate"] > f["false_trigger_rate"] + args.false_trigger_rise:
+        regressions.append(f"{g['name']}: false triggers {f['false_trigger_rate']:.4f} fixed -> "
+                           f"{c['false_trigger_rate']:.4f} governed")
+
+# Scripted decision cases: a fixed number of plays, whatever the baseline says
+for d in cur.get("decisions", []):
+    if d["plays"] != d["expected"]:
+        regressions.append(f"{d['name']}: {d['plays']} plays, expected {d['expected']}")
+
+# A flight recorder dump replays to the glove's own decisions
+for d in cur.get("recorder_replay", []):
+    if d["mismatches"]:
+        regressions.append(f"{d['name']}: {d['mismatches']} of {d['frames']} frames replay to another decision")
+
+for r in regressions:
+    print("❌", r)
+if regressions:
+    sys.exit(1)
+print("✅ No regressions")
@@ -0,0 +1,275 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dfplayer_emu.h"
+
+#define BYTE_MS  (10 * 1000.0 / DFPLAYER_BAUD)   // start + 8 data + stop bits
+#define FRAME_MS (DFPLAYER_FRAME_LEN * BYTE_MS)
+
+#define STORAGE_SD 0x02   // param of the online frame
+
+static const char *const event_names[] = {
+    [EMU_EV_ONLINE] = "online", [EMU_EV_COMMAND] = "command", [EMU_EV_DROPPED] = "dropped",
+    [EMU_EV_ERROR] = "error", [EMU_EV_START] = "start", [EMU_EV_FINISHED] = "finished", [EMU_EV_CUT] = "cut",
+};
+
+static void log_event(dfplayer_emu_t *e, double t, int type, uint8_t cmd, uint16_t param, double heard) {
+    if (e->n_events == e->cap_events) {
+        e->cap_events = e->cap_events ? 2 * e->cap_events : 64;
+        e->events = realloc(e->events, e->cap_events * sizeof(*e->events));
+    }
+    e->events[e->n_events++] = (dfplayer_emu_event_t){ t, type, cmd, param, heard };
+}
+
+// Reply frame starting on the TX line at t; a full buffer loses its oldest frame
+static void queue_reply(dfplayer_emu_t *e, double t, uint8_t cmd, uint16_t param) {
+    if (e->tx_len == DFPLAYER_EMU_TX_FRAMES) {
+        memmove(e->tx, e->tx + 1, sizeof(e->tx) - sizeof(e->tx[0]));
+        memmove(e->tx_due_ms, e->tx_due_ms + 1, sizeof(e->tx_due_ms) - sizeof(e->tx_due_ms[0]));
+        e->tx_len--;
+    }
+    double due = t + FRAME_MS;
+    int i = e->tx_len++;
+    for (; i > 0 && e->tx_due_ms[i - 1] > due; i--) {
+        memcpy(e->tx[i], e->tx[i - 1], DFPLAYER_FRAME_LEN);
+        e->tx_due_ms[i] = e->tx_due_ms[i - 1];
+    }
+    dfplayer_build_frame(e->tx[i], cmd, param, false);
+    e->tx_due_ms[i] = due;
+}
+
+// Clip length of a track, < 0 if the card has no such file
+static double clip_len(const dfplayer_emu_t *e, int track) {
+    if (track <= 0) return -1;
+    if (!e->cfg.track_ms) return e->cfg.default_clip_ms;
+    if (track >= e->cfg.n_tracks || !e->cfg.track_ms[track]) return -1;
+    return e->cfg.track_ms[track];
+}
+
+static void stop_audio(dfplayer_emu_t *e, double t, bool finished) {
+    if (!e->track) return;
+    double heard = e->audible ? t - e->start_at_ms : 0;
+    log_event(e, t, finished ? EMU_EV_FINISHED : EMU_EV_CUT, CMD_PLAY_TRACK, e->track, heard);
+    e->stats.heard_ms += heard;
+    if (finished) {
+        // The module reports the end of a track twice
+        e->stats.finished++;
+        queue_reply(e, t, CMD_TRACK_DONE, e->track);
+        queue_reply(e, t + FRAME_MS, CMD_TRACK_DONE, e->track);
+    } else {
+        e->stats.cut++;
+        if (e->audible) {
+            e->silenced = true;
+            e->cut_at_ms = t;
+        }
+    }
+    e->track = 0;
+    e->audible = false;
+}
+
+static void execute(dfplayer_emu_t *e, double t, const dfplayer_frame_t *f, double sent_ms) {
+    log_event(e, t, EMU_EV_COMMAND, f->cmd, f->param, 0);
+    if (f->feedback) queue_reply(e, t + e->cfg.ack_ms, CMD_ACK, 0);
+
+    switch (f->cmd) {
+    case CMD_PLAY_TRACK: {
+        double len = clip_len(e, f->param);
+        if (len < 0) {
+            queue_reply(e, t, CMD_ERROR, DFPLAYER_ERR_NOT_FOUND);
+            log_event(e, t, EMU_EV_ERROR, f->cmd, DFPLAYER_ERR_NOT_FOUND, 0);
+            break;
+        }
+        stop_audio(e, t, false);
+        e->track = f->param;
+        e->sent_ms = sent_ms;
+        e->start_at_ms = t + e->cfg.start_ms;
+        e->end_at_ms = e->start_at_ms + len;
+        e->stats.plays++;
+        break;
+    }
+    case CMD_RESET:
+        stop_audio(e, t, false);
+        e->online = false;
+        e->power_on_ms = t;
+        break;
+    case CMD_ONLINE:
+        queue_reply(e, t, CMD_ONLINE, STORAGE_SD);
+        break;
+    default:   // volume, EQ, ...: accepted, nothing to emulate
+        break;
+    }
+}
+
+// Process everything scheduled up to t, earliest first
+static void advance(dfplayer_emu_t *e, double t) {
+    enum { NONE, ONLINE, EXECUTE, START, END };
+
+    for (;;) {
+        double next = t;
+        int what = NONE;
+        if (!e->online && e->power_on_ms + e->cfg.boot_ms <= next) {
+            next = e->power_on_ms + e->cfg.boot_ms;
+            what = ONLINE;
+        }
+        if (e->pending && e->pending_ms <= next) {
+            next = e->pending_ms;
+            what = EXECUTE;
+        }
+        if (e->track && !e->audible && e->start_at_ms <= next) {
+            next = e->start_at_ms;
+            what = START;
+        }
+        if (e->track && e->audible && e->end_at_ms <= next) {
+            next = e->end_at_ms;
+            what = END;
+        }
+        if (what == NONE) break;
+
+        switch (what) {
+        case ONLINE:
+            e->online = true;
+            queue_reply(e, next, CMD_ONLINE, STORAGE_SD);
+            log_event(e, next, EMU_EV_ONLINE, CMD_ONLINE, STORAGE_SD, 0);
+            break;
+        case EXECUTE:
+            e->pending = false;
+            execute(e, next, &e->pending_frame, e->pending_sent_ms);
+            break;
+        case START: {
+            double latency = next - e->sent_ms;
+            e->audible = true;
+            e->stats.started++;
+            e->stats.latency_ms += latency;
+            if (latency > e->stats.latency_max_ms) e->stats.latency_max_ms = latency;
+            if (e->silenced) {
+                e->stats.gap_ms += next - e->cut_at_ms;
+                e->stats.gaps++;
+                e->silenced = false;
+            }
+            log_event(e, next, EMU_EV_START, CMD_PLAY_TRACK, e->track, 0);
+            break;
+        }
+        case END:
+            stop_audio(e, next, true);
+            break;
+        }
+    }
+    if (t > e->now_ms) e->now_ms = t;
+}
+
+// A whole frame has arrived at t
+static void receive(dfplayer_emu_t *e, double t, const dfplayer_frame_t *f) {
+    advance(e, t);
+    e->stats.frames++;
+    if (!e->online) {
+        queue_reply(e, t, CMD_ERROR, DFPLAYER_ERR_BUSY);
+        log_event(e, t, EMU_EV_ERROR, f->cmd, DFPLAYER_ERR_BUSY, 0);
+    } else if (e->pending) {
+        e->stats.dropped++;
+        log_event(e, t, EMU_EV_DROPPED, f->cmd, f->param, 0);
+    } else {
+        e->pending = true;
+        e->pending_frame = *f;
+        e->pending_ms = t + e->cfg.decode_ms;
+        e->pending_sent_ms = t - FRAME_MS;
+    }
+}
+
+// Start, version, length and end bytes in place: a parse failure is then a bad checksum
+static bool framed(const uint8_t *buf, size_t len) {
+    size_t start = 0;
+    while (start < len && buf[start] != 0x7E) start++;
+    const uint8_t *p = buf + start;
+    return len - start >= DFPLAYER_FRAME_LEN && p[1] == 0xFF && p[2] == 0x06 && p[9] == 0xEF;
+}
+
+void dfplayer_emu_init(dfplayer_emu_t *e, const dfplayer_emu_cfg_t *cfg, double power_on_ms) {
+    memset(e, 0, sizeof(*e));
+    e->cfg = *cfg;
+    e->power_on_ms = power_on_ms;
+    e->now_ms = e->wire_free_ms = power_on_ms;
+}
+
+void dfplayer_emu_free(dfplayer_emu_t *e) {
+    free(e->events);
+    e->events = NULL;
+    e->n_events = e->cap_events = 0;
+}
+
+void dfplayer_emu_write(dfplayer_emu_t *e, double t_ms, const uint8_t *buf, size_t len) {
+    double at = t_ms > e->wire_free_ms ? t_ms : e->wire_free_ms;
+
+    for (size_t i = 0; i < len; i++) {
+        at += BYTE_MS;
+        if (e->rx_len == sizeof(e->rx)) {
+            memmove(e->rx, e->rx + 1, --e->rx_len);
+        }
+        e->rx[e->rx_len++] = buf[i];
+
+        size_t used;
+        do {
+            dfplayer_frame_t f;
+            bool valid, shaped = framed(e->rx, e->rx_len);
+            used = dfplayer_parse_frame(e->rx, e->rx_len, &f, &valid);
+            if (valid) {
+                receive(e, at, &f);
+            } else if (shaped && used > 0) {
+                advance(e, at);
+                e->stats.bad_frames++;
+                queue_reply(e, at, CMD_ERROR, DFPLAYER_ERR_CHECKSUM);
+                log_event(e, at, EMU_EV_ERROR, 0, DFPLAYER_ERR_CHECKSUM, 0);
+            }
+            e->rx_len -= used;
+            memmove(e->rx, e->rx + used, e->rx_len);
+        } while (used > 0);
+    }
+    e->wire_free_ms = at;
+}
+
+size_t dfplayer_emu_read(dfplayer_emu_t *e, double t_ms, uint8_t *out, size_t cap) {
+    size_t n = 0;
+    advance(e, t_ms);
+    while (e->tx_len > 0 && e->tx_due_ms[0] <= t_ms && n + DFPLAYER_FRAME_LEN <= cap) {
+        memcpy(out + n, e->tx[0], DFPLAYER_FRAME_LEN);
+        n += DFPLAYER_FRAME_LEN;
+        e->tx_len--;
+        memmove(e->tx, e->tx + 1, e->tx_len * sizeof(e->tx[0]));
+        memmove(e->tx_due_ms, e->tx_due_ms + 1, e->tx_len * sizeof(e->tx_due_ms[0]));
+    }
+    return n;
+}
+
+bool dfplayer_emu_busy(dfplayer_emu_t *e, double t_ms) {
+    advance(e, t_ms);
+    return e->track && e->audible;
+}
+
+void dfplayer_emu_drain(dfplayer_emu_t *e) {
+    while (e->pending || e->track) {
+        advance(e, e->pending ? e->pending_ms : e->audible ? e->end_at_ms : e->start_at_ms);
+    }
+}
+
+void dfplayer_emu_print_timeline(const dfplayer_emu_t *e, size_t from, FILE *out) {
+    for (size_t i = from; i < e->n_events; i++) {
+        const dfplayer_emu_event_t *ev = &e->events[i];
+        fprintf(out, "%10.1f ms  %-9s", ev->t_ms, event_names[ev->type]);
+        switch (ev->type) {
+        case EMU_EV_COMMAND:
+        case EMU_EV_DROPPED:
+            fprintf(out, "cmd 0x%02X param %u\n", ev->cmd, ev->param);
+            break;
+        case EMU_EV_ERROR:
+            fprintf(out, "code 0x%02X\n", ev->param);
+            break;
+        case EMU_EV_START:
+            fprintf(out, "%04u.mp3\n", ev->param);
+            break;
+        case EMU_EV_FINISHED:
+        case EMU_EV_CUT:
+            fprintf(out, "%04u.mp3 heard %.0f ms\n", ev->param, ev->heard_ms);
+            break;
+        default:
+            fputc('\n', out);
+        }
+    }
+}
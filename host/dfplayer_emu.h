@@ -0,0 +1,109 @@
+// DFPlayer Mini emulator: the serial protocol and timing of the module on a
+// virtual clock in ms, so the audio path can be tested without hardware.
+// Bytes written to it are timed at DFPLAYER_BAUD; replies (online, ACK, error,
+// track finished) come back on the same clock.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "dfplayer.h"
+
+#define DFPLAYER_EMU_TX_FRAMES 16   // reply frames held for the reader, oldest dropped first
+
+typedef struct {
+    const uint32_t *track_ms;       // clip length by track (audio_load_durations), NULL = every track exists
+    int n_tracks;
+    double default_clip_ms;         // length of a track with no file when track_ms is NULL
+    double boot_ms;                 // power-on -> online frame (SD card scan)
+    double decode_ms;               // frame received -> command executed; frames meanwhile are lost
+    double start_ms;                // play executed -> audible (seek + MP3 decoder start)
+    double ack_ms;                  // command executed -> ACK, when the frame asked for feedback
+} dfplayer_emu_cfg_t;
+
+// Rough figures of a module reading a class 10 card; override to test slower ones
+#define DFPLAYER_EMU_DEFAULTS { .default_clip_ms = 2000, .boot_ms = 1500, .decode_ms = 30, .start_ms = 90, .ack_ms = 12 }
+
+typedef enum {
+    EMU_EV_ONLINE,                  // storage online frame sent
+    EMU_EV_COMMAND,                 // valid frame executed
+    EMU_EV_DROPPED,                 // valid frame lost while the previous one was decoded
+    EMU_EV_ERROR,                   // error frame sent, param = DFPLAYER_ERR_*
+    EMU_EV_START,                   // track audible
+    EMU_EV_FINISHED,                // track played to the end
+    EMU_EV_CUT,                     // track stopped by the next command
+} dfplayer_emu_event_type_t;
+
+typedef struct {
+    double t_ms;
+    uint8_t type;                   // dfplayer_emu_event_type_t
+    uint8_t cmd;
+    uint16_t param;                 // track for START/FINISHED/CUT
+    double heard_ms;                // FINISHED/CUT: audio actually heard
+} dfplayer_emu_event_t;
+
+typedef struct {
+    size_t frames;                  // valid frames received
+    size_t bad_frames;              // well framed, bad checksum
+    size_t dropped;
+    size_t plays;                   // play commands executed
+    size_t started;                 // of which became audible
+    size_t finished, cut;
+    double heard_ms;
+    double latency_ms;              // summed: first byte of a play command -> audible
+    double latency_max_ms;
+    double gap_ms;                  // summed silence between a cut clip and the next one
+    size_t gaps;
+} dfplayer_emu_stats_t;
+
+typedef struct {
+    dfplayer_emu_cfg_t cfg;
+    double now_ms;
+    double power_on_ms;
+    bool online;
+
+    // Receive side: bytes on the wire and the frame being decoded
+    double wire_free_ms;
+    uint8_t rx[2 * DFPLAYER_FRAME_LEN];
+    size_t rx_len;
+    bool pending;
+    dfplayer_frame_t pending_frame;
+    double pending_ms, pending_sent_ms;
+
+    // Audio output
+    int track;                      // 0 = silent
+    bool audible;
+    double sent_ms, start_at_ms, end_at_ms;
+    bool silenced;                  // a clip was cut at cut_at_ms, the next start closes the gap
+    double cut_at_ms;
+
+    // Reply frames not read yet, in due order
+    uint8_t tx[DFPLAYER_EMU_TX_FRAMES][DFPLAYER_FRAME_LEN];
+    double tx_due_ms[DFPLAYER_EMU_TX_FRAMES];
+    int tx_len;
+
+    dfplayer_emu_event_t *events;
+    size_t n_events, cap_events;
+    dfplayer_emu_stats_t stats;
+} dfplayer_emu_t;
+
+// Module powered on at power_on_ms; the online frame follows after cfg->boot_ms
+void dfplayer_emu_init(dfplayer_emu_t *e, const dfplayer_emu_cfg_t *cfg, double power_on_ms);
+void dfplayer_emu_free(dfplayer_emu_t *e);
+
+// Bytes the MCU starts sending at t_ms (non-decreasing across calls)
+void dfplayer_emu_write(dfplayer_emu_t *e, double t_ms, const uint8_t *buf, size_t len);
+
+// Reply bytes on the module's TX line by t_ms; returns bytes copied
+size_t dfplayer_emu_read(dfplayer_emu_t *e, double t_ms, uint8_t *out, size_t cap);
+
+// Run the clock to t_ms; the BUSY pin is low (true here) while a track is audible
+bool dfplayer_emu_busy(dfplayer_emu_t *e, double t_ms);
+
+// Run the clock until the current track has finished
+void dfplayer_emu_drain(dfplayer_emu_t *e);
+
+// What would have been heard, one event per line
+void dfplayer_emu_print_timeline(const dfplayer_emu_t *e, size_t from, FILE *out);
@@ -0,0 +1,135 @@
+// DFPlayer Mini emulator on a pseudo-terminal: point anything that talks to the
+// module over serial at the printed device, watch what would have been heard.
+//   host/build/flexsonic_dfplayer --audio audio --timeline timeline.txt
+
+#define _DEFAULT_SOURCE       // cfmakeraw, cfsetspeed
+#define _XOPEN_SOURCE 600     // posix_openpt, ptsname
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "audio.h"
+#include "dfplayer_emu.h"
+
+#ifndef FLEXSONIC_ROOT
+#define FLEXSONIC_ROOT ".."
+#endif
+
+#define POLL_MS 2
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static double wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Master side of a raw pty; the slave stays open so the line survives clients reconnecting
+static int open_pty(char *name, size_t len, int *slave) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) return -1;
+    snprintf(name, len, "%s", ptsname(master));
+
+    *slave = open(name, O_RDWR | O_NOCTTY);
+    if (*slave < 0) return -1;
+    struct termios tio;
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B9600);
+    tcsetattr(*slave, TCSANOW, &tio);
+    return master;
+}
+
+// "decode,start,ack" in ms
+static void parse_latency(const char *arg, dfplayer_emu_cfg_t *cfg) {
+    sscanf(arg, "%lf,%lf,%lf", &cfg->decode_ms, &cfg->start_ms, &cfg->ack_ms);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--audio dir] [--latency decode,start,ack] [--boot-ms N] [--timeline out.txt]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    dfplayer_emu_cfg_t cfg = DFPLAYER_EMU_DEFAULTS;
+    const char *audio_dir = FLEXSONIC_ROOT "/audio", *timeline_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--audio") && i + 1 < argc) audio_dir = argv[++i];
+        else if (!strcmp(argv[i], "--latency") && i + 1 < argc) parse_latency(argv[++i], &cfg);
+        else if (!strcmp(argv[i], "--boot-ms") && i + 1 < argc) cfg.boot_ms = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--timeline") && i + 1 < argc) timeline_path = argv[++i];
+        else usage(argv[0]);
+    }
+
+    static uint32_t track_ms[AUDIO_MAX_TRACKS];
+    int n_clips = audio_load_durations(audio_dir, track_ms);
+    if (n_clips) {
+        cfg.track_ms = track_ms;
+        cfg.n_tracks = AUDIO_MAX_TRACKS;
+    } else {
+        fprintf(stderr, "no clips in %s, every track plays %.0f ms\n", audio_dir, cfg.default_clip_ms);
+    }
+
+    char name[64];
+    int slave;
+    int master = open_pty(name, sizeof(name), &slave);
+    if (master < 0) {
+        perror("pty");
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    printf("DFPlayer emulator on %s (%d clips, decode %.0f ms, start %.0f ms, ack %.0f ms)\n",
+           name, n_clips, cfg.decode_ms, cfg.start_ms, cfg.ack_ms);
+    fflush(stdout);
+
+    dfplayer_emu_t emu;
+    double t0 = wall_ms();
+    size_t shown = 0;
+    dfplayer_emu_init(&emu, &cfg, 0);
+
+    while (!stop) {
+        struct pollfd pfd = { .fd = master, .events = POLLIN };
+        uint8_t buf[256];
+        if (poll(&pfd, 1, POLL_MS) > 0 && (pfd.revents & POLLIN)) {
+            ssize_t n = read(master, buf, sizeof(buf));
+            if (n > 0) dfplayer_emu_write(&emu, wall_ms() - t0, buf, n);
+        }
+        size_t n = dfplayer_emu_read(&emu, wall_ms() - t0, buf, sizeof(buf));
+        if (n > 0 && write(master, buf, n) < 0) break;
+
+        dfplayer_emu_print_timeline(&emu, shown, stdout);
+        shown = emu.n_events;
+        fflush(stdout);
+    }
+
+    const dfplayer_emu_stats_t *st = &emu.stats;
+    printf("\n%zu frames, %zu bad, %zu dropped, %zu plays (%zu cut), %.1f s heard, "
+           "latency %.0f ms mean / %.0f ms max, gap %.0f ms mean\n",
+           st->frames, st->bad_frames, st->dropped, st->plays, st->cut, st->heard_ms / 1000,
+           st->started ? st->latency_ms / st->started : 0.0, st->latency_max_ms,
+           st->gaps ? st->gap_ms / st->gaps : 0.0);
+    if (timeline_path) {
+        FILE *out = fopen(timeline_path, "w");
+        if (out) {
+            dfplayer_emu_print_timeline(&emu, 0, out);
+            fclose(out);
+        }
+    }
+    dfplayer_emu_free(&emu);
+    close(slave);
+    close(master);
+    return 0;
+}
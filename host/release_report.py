@@ -0,0 +1,133 @@
+import argparse, json, os, re, subprocess, sys
+
+# Release profile report: RAM/flash per component from the link map, cycles per
+# kernel from the KERNEL_CYCLES line of a serial log, flex sensor state from the
+# HEALTH line, sampling levels from the GOVERNOR line. Fails if the frame loop allocated or overran its budget.
+#   idf.py -B build_release -D SDKCONFIG=build_release/sdkconfig -D SDKCONFIG_DEFAULTS="sdkconfig;sdkconfig.release" build flash monitor | tee serial.log
+#   python host/release_report.py --build build_release --log serial.log --json release.json
+parser = argparse.ArgumentParser()
+parser.add_argument("--build", default="build_release", help="Build directory of the release profile")
+parser.add_argument("--log", help="Serial log with at least one KERNEL_CYCLES line")
+parser.add_argument("--cpu_mhz", type=int, default=240)
+parser.add_argument("--json", help="Write the report as JSON too")
+args = parser.parse_args()
+
+
+def component_sizes(build):
+    maps = [f for f in os.listdir(build) if f.endswith(".map")]
+    if not maps:
+        raise SystemExit(f"❌ No link map in {build}, build the release profile first")
+    idf_size = os.path.join(os.environ.get("IDF_PATH", ""), "tools", "idf_size.py")
+    out = subprocess.run([sys.executable, idf_size, "--archives", "--format", "json",
+                          os.path.join(build, maps[0])], capture_output=True, text=True, check=True).stdout
+    sizes = {}
+    for archive, sections in json.loads(out).items():
+        ram = sum(v for k, v in sections.items() if "dram" in k or "iram" in k or "bss" in k)
+        flash = sum(v for k, v in sections.items() if "flash" in k)
+        iram = sum(v for k, v in sections.items() if "iram" in k)
+        sizes[archive.replace(".a", "").replace("lib", "", 1)] = {"ram": ram, "iram": iram, "flash": flash}
+    return sizes
+
+
+def kernel_cycles(log_path, cpu_mhz):
+    line = None
+    with open(log_path, errors="replace") as f:
+        for l in f:
+            if "KERNEL_CYCLES" in l:
+                line = l
+    if line is None:
+        raise SystemExit(f"❌ No KERNEL_CYCLES line in {log_path}")
+    fields = dict(re.findall(r"(\w+)=([-\d/]+)", line.split("KERNEL_CYCLES", 1)[1]))
+    kernels = {}
+    for name, value in fields.items():
+        if "/" in value:
+            avg, worst, *count = (int(v) for v in value.split("/"))
+            kernels[name] = {"avg_cycles": avg, "max_cycles": worst,
+                             "avg_us": avg / cpu_mhz, "max_us": worst / cpu_mhz}
+            if count:
+                kernels[name]["count"] = count[0]
+    # Share of frames each cascade stage settled
+    frames = kernels.get("frame", {}).get("count", 0)
+    for name, k in kernels.items():
+        if name.startswith("stage_") and frames:
+            k["hit_rate"] = k.get("count", 0) / frames
+    return kernels, {k: int(v) for k, v in fields.items() if "/" not in v}
+
+
+def sensor_health(log_path):
+    """Last HEALTH line: state/mean/sd/noise/rail_hits per finger"""
+    line = None
+    with open(log_path, errors="replace") as f:
+        for l in f:
+            if "HEALTH" in l:
+                line = l
+    if line is None:
+        return {}
+    health = {}
+    for name, state, fault, *stats in re.findall(r"(\w+)=(\w+)(?:\((\w+)\))?/(\d+)/(\d+)/(\d+)/(\d+)", line):
+        health[name] = {"state": state, "fault": fault or None,
+                        **dict(zip(["mean", "sd", "noise", "rail_hits"], map(int, stats)))}
+    return health
+
+
+def governor(log_path):
+    """Last GOVERNOR line: current level, activity and time share per level"""
+    line = None
+    with open(log_path, errors="replace") as f:
+        for l in f:
+            if "GOVERNOR level=" in l:
+                line = l
+    if line is None:
+        return {}
+    fields = dict(re.findall(r"(\w+)=(\w+)%?", line.split("GOVERNOR", 1)[1]))
+    return {k: v if k == "level" else int(v) for k, v in fields.items()}
+
+
+report = {"components": component_sizes(args.build)}
+print(f"{'component':<28}{'RAM':>10}{'of which IRAM':>15}{'flash':>10}")
+for name, s in sorted(report["components"].items(), key=lambda kv: -kv[1]["ram"] - kv[1]["flash"]):
+    print(f"{name:<28}{s['ram']:>10}{s['iram']:>15}{s['flash']:>10}")
+
+failures = []
+if args.log:
+    kernels, totals = kernel_cycles(args.log, args.cpu_mhz)
+    report["kernels"], report["frame"] = kernels, totals
+    print(f"\n{'kernel':<16}{'avg cycles':>12}{'max cycles':>12}{'max us':>10}{'of frames':>11}")
+    for name, k in kernels.items():
+        share = f"{100 * k['hit_rate']:>10.1f}%" if "hit_rate" in k else ""
+        print(f"{name:<16}{k['avg_cycles']:>12}{k['max_cycles']:>12}{k['max_us']:>10.1f}{share}")
+    print(f"\nbudget {totals.get('budget', 0)} cycles, {totals.get('overruns', 0)} overruns, "
+          f"{totals.get('stalled', 0)} frames stalled by recorder flash writes (not timed), "
+          f"{totals.get('allocs', -1)} allocations in the frame loop")
+    if totals.get("allocs", -1) < 0:
+        failures.append("heap hooks compiled out, allocations not checked (CONFIG_HEAP_USE_HOOKS)")
+    elif totals["allocs"] > 0:
+        failures.append(f"{totals['allocs']} heap allocations in the frame loop")
+    if totals.get("overruns", 0) > 0:
+        failures.append(f"{totals['overruns']} frames over budget")
+
+    report["health"] = sensor_health(args.log)
+    if report["health"]:
+        print(f"\n{'finger':<10}{'state':<16}{'mean':>6}{'sd':>6}{'noise':>7}{'rail hits':>11}")
+        for name, h in report["health"].items():
+            state = f"{h['state']}({h['fault']})" if h["fault"] else h["state"]
+            print(f"{name:<10}{state:<16}{h['mean']:>6}{h['sd']:>6}{h['noise']:>7}{h['rail_hits']:>11}")
+        dead = [name for name, h in report["health"].items() if h["state"] == "dead"]
+        if dead:
+            print(f"⚠️  Recognising without {', '.join(dead)}")
+
+    report["governor"] = governor(args.log)
+    if report["governor"]:
+        g = report["governor"]
+        print(f"\ngovernor at {g['level']}: rest {g.get('rest', 0)}%, ready {g.get('ready', 0)}%, "
+              f"motion {g.get('motion', 0)}% of the time, {g.get('switches', 0)} switches")
+
+if args.json:
+    with open(args.json, "w") as f:
+        json.dump(report, f, indent=2)
+
+for r in failures:
+    print("❌", r)
+if failures:
+    sys.exit(1)
+print("✅ Release profile checks passed")
@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dfplayer.h"
+#include "flex_filter.h"
+#include "flex_health.h"
+#include "recorder.h"
+#include "replay.h"
+
+#define RAW_MAX_FRAMES 128  // largest block a governor level asks for (FLEX_ADC_MAX_FRAMES)
+#define RAW_FRAME_HZ 4000   // DMA frames per second (FLEX_ADC_FRAME_HZ)
+
+// Same filter settings as flexsonic.c
+static const flex_filter_cfg_t filter_cfg = FLEX_FILTER_DEFAULTS;
+
+// Without --governor the firmware's fixed period: every frame sampled like READY
+static const governor_cfg_t firmware_levels = GOVERNOR_DEFAULTS;
+
+const char *const replay_stage_names[GESTURE_STAGES] = {
+    [GESTURE_STAGE_MASK] = "mask", [GESTURE_STAGE_RULES] = "rules",
+    [GESTURE_STAGE_STEADY] = "steady", [GESTURE_STAGE_CENTROID] = "centroid",
+};
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng_next(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint16_t clamp_adc(int v) {
+    return v < 0 ? 0 : v > 4095 ? 4095 : v;
+}
+
+// Raw interleaved DMA frames around the logged value, as the ADC would deliver them
+static void fill_raw(uint16_t *raw, int n_frames, const session_frame_t *sf) {
+    for (int k = 0; k < n_frames; k++) {
+        for (int i = 0; i < NUM_FLEX; i++) {
+            raw[k * FLEX_CHANNELS + i] = clamp_adc(sf->flex[i] + (int)(rng_next() % 41) - 20);
+        }
+    }
+}
+
+// Failed sensors override what the ADC would have read
+static uint8_t inject_faults(uint16_t *raw, int n_frames, const replay_cfg_t *cfg, double now) {
+    uint8_t failed = 0;
+    for (int i = 0; i < cfg->n_faults; i++) {
+        const replay_fault_t *fault = &cfg->faults[i];
+        if (now < fault->from_ms || fault->channel >= FLEX_CHANNELS) continue;
+        failed |= 1u << fault->channel;
+        if (fault->kind == REPLAY_FAULT_NONE) continue;
+        for (int k = 0; k < n_frames; k++) {
+            raw[k * FLEX_CHANNELS + fault->channel] =
+                fault->kind == REPLAY_FAULT_NOISE ? rng_next() & 0xFFF : fault->value;
+        }
+    }
+    return failed;
+}
+
+// Fingers the rules and clusters of a track bend
+static uint8_t track_fingers(const model_blob_view_t *m, int track) {
+    uint8_t mask = 0;
+    for (int i = 0; i < m->header->n_rules; i++) {
+        if (m->rules[i].track == track && !(m->rules[i].flags & MODEL_RULE_GYRO)) mask |= m->rules[i].flex_mask;
+    }
+    for (int c = 0; c < m->header->n_clusters; c++) {
+        if (m->cluster_track[c] == track) mask |= gesture_cluster_fingers(m, c);
+    }
+    return mask;
+}
+
+static uint32_t clip_ms(const replay_cfg_t *cfg, int track) {
+    if (!cfg->track_ms || track >= cfg->n_tracks || !cfg->track_ms[track]) return REPLAY_DEFAULT_CLIP_MS;
+    return cfg->track_ms[track];
+}
+
+// Frame times: logged timestamps when they advance, else the firmware loop period
+static double frame_time(const session_t *s, size_t k) {
+    bool stamped = s->n > 1 && s->frames[s->n - 1].t_ms > s->frames[0].t_ms;
+    return stamped ? s->frames[k].t_ms - s->frames[0].t_ms : (double)k * REPLAY_FRAME_MS;
+}
+
+// Logged frame nearest to t, with the readings interpolated between the frames
+// either side as a faster frame loop would have seen them. *cursor is the last
+// frame at or before t; t only moves forward.
+static size_t frame_at(const session_t *s, size_t *cursor, double t, session_frame_t *out) {
+    size_t k = *cursor;
+    while (k + 1 < s->n && frame_time(s, k + 1) <= t) k++;
+    *cursor = k;
+    *out = s->frames[k];
+    if (k + 1 == s->n) return k;
+
+    double t0 = frame_time(s, k), t1 = frame_time(s, k + 1);
+    double w = t1 > t0 ? (t - t0) / (t1 - t0) : 0;
+    const session_frame_t *a = &s->frames[k], *b = &s->frames[k + 1];
+    for (int i = 0; i < NUM_FLEX; i++) out->flex[i] = a->flex[i] + (int)((b->flex[i] - a->flex[i]) * w);
+    for (int i = 0; i < 3; i++) out->gyro[i] = a->gyro[i] + (int)((b->gyro[i] - a->gyro[i]) * w);
+    if (w >= 0.5) {
+        out->label = b->label;
+        return k + 1;
+    }
+    return k;
+}
+
+static uint8_t clamp_shift(int shift) {
+    return shift < 0 ? 0 : shift > 6 ? 6 : shift;
+}
+
+// A play is judged against the frame's label or, inside an unlabelled
+// transition, against the gesture the hand is moving into
+static int16_t *target_labels(const session_t *s) {
+    int16_t *target = malloc(s->n * sizeof(*target));
+    int16_t next = LABEL_UNKNOWN;
+    for (size_t k = s->n; k-- > 0;) {
+        if (s->frames[k].label != LABEL_UNKNOWN) next = s->frames[k].label;
+        target[k] = next;
+    }
+    return target;
+}
+
+void replay_session(const session_t *s, const model_blob_view_t *m, const replay_cfg_t *cfg, replay_result_t *r) {
+    const governor_cfg_t *gcfg = s->recorded ? NULL : cfg->governor;
+    int16_t *target = target_labels(s);
+    uint16_t raw[RAW_MAX_FRAMES * FLEX_CHANNELS], filtered[RAW_MAX_FRAMES * FLEX_CHANNELS];
+    uint8_t packet[DFPLAYER_FRAME_LEN];
+    gesture_state_t state = { 0 };
+    uint64_t total = 0;
+    size_t n_lat = 0;
+    flex_filter_t filter;
+    flex_health_t *health = &r->health;
+    governor_t *gov = &r->governor;
+    flex_filter_cfg_t fcfg = filter_cfg;
+    gesture_frame_t f = { { 0 }, { 0 }, 0 };
+    gesture_result_t res;
+
+    // Clip currently audible
+    double clip_start = 0, clip_end = 0;
+    bool clip_wrong = false;
+
+    // Labelled gesture currently being made, for latency-to-decision
+    int16_t segment_label = LABEL_UNKNOWN;
+    double segment_start = 0;
+    bool segment_done = false;
+
+    // With a player, frames logged while the loop slept are never sampled
+    double asleep_until = -1;
+
+    rng_state = cfg->seed ? cfg->seed : 1;
+    if (m->header->decimation) {   // same rule as apply_model_filter() in flexsonic.c
+        fcfg.median_n = m->header->median_n;
+        fcfg.iir_shift = m->header->iir_shift;
+        fcfg.decimation = m->header->decimation;
+    }
+    flex_filter_init(&filter, &fcfg);
+
+    memset(r, 0, sizeof(*r));
+    flex_health_init(health);
+    snprintf(r->name, sizeof(r->name), "%.63s", s->name);
+    r->frames = s->n;
+    r->session_ms = s->n ? frame_time(s, s->n - 1) + REPLAY_FRAME_MS : 0;
+
+    // The governor can run more frames than were logged
+    size_t cap_lat = s->n;
+    if (gcfg) {
+        r->governed = true;
+        governor_init(gov, gcfg);
+        flex_filter_set_iir(&filter, clamp_shift(fcfg.iir_shift + governor_setting(gov)->iir_delta));
+        uint16_t fastest = UINT16_MAX;
+        for (int l = 0; l < GOVERNOR_LEVELS; l++) {
+            if (gcfg->level[l].frame_ms && gcfg->level[l].frame_ms < fastest) fastest = gcfg->level[l].frame_ms;
+        }
+        cap_lat = (size_t)(r->session_ms / fastest) + 2;
+    }
+    uint64_t *lat = malloc(cap_lat * sizeof(*lat));
+
+    size_t k = 0, cursor = 0, seg_k = 0;
+    double now = 0, prev_now = 0;
+    while (gcfg ? s->n && now < r->session_ms - REPLAY_FRAME_MS / 2.0 && n_lat < cap_lat : k < s->n) {
+        session_frame_t lerp;
+        const session_frame_t *sf;
+        int n_raw = firmware_levels.level[GOVERNOR_READY].raw_frames;
+        if (gcfg) {
+            k = frame_at(s, &cursor, now, &lerp);
+            sf = &lerp;
+            n_raw = governor_setting(gov)->raw_frames;
+            if (n_raw > RAW_MAX_FRAMES) n_raw = RAW_MAX_FRAMES;
+        } else {
+            now = frame_time(s, k);
+            sf = &s->frames[k];
+        }
+
+        // A segment is a run of one gesture, starting with the transition into it
+        for (; seg_k <= k; seg_k++) {
+            if (target[seg_k] != LABEL_UNKNOWN && target[seg_k] != segment_label) {
+                segment_label = target[seg_k];
+                segment_start = frame_time(s, seg_k);
+                segment_done = false;
+                if (segment_label > 0) r->segments++;
+            }
+        }
+        if (now < asleep_until && !s->recorded) {
+            r->skipped++;
+            k++;
+            continue;
+        }
+
+        uint8_t failed = 0;
+        uint64_t t0 = now_ns();
+        if (s->recorded) {
+            // Filtered and judged on the glove already
+            for (int i = 0; i < NUM_FLEX; i++) f.flex[i] = sf->flex[i];
+            f.dead_mask = sf->dead_mask;
+            state.frame_ms = firmware_levels.level[sf->level < GOVERNOR_LEVELS ? sf->level : GOVERNOR_READY].frame_ms;
+        } else {
+            fill_raw(raw, n_raw, sf);
+            failed = inject_faults(raw, n_raw, cfg, now);
+            t0 = now_ns();
+            int n_out = flex_filter_block(&filter, raw, n_raw, filtered);
+            flex_health_block(health, raw, n_raw);
+            // A block too short to emit a frame keeps the last reading, as read_flex() does
+            if (n_out > 0) {
+                for (int i = 0; i < NUM_FLEX; i++) f.flex[i] = filtered[(n_out - 1) * FLEX_CHANNELS + i];
+            }
+            f.dead_mask = cfg->no_health ? 0 : health->dead_mask;
+        }
+        memcpy(f.gyro, sf->gyro, sizeof(f.gyro));
+        if (gcfg) state.frame_ms = governor_setting(gov)->frame_ms;
+        uint64_t t1 = now_ns();
+        int track = gesture_decide(m, &f, &state, &res);
+        uint64_t t2 = now_ns();
+        if (s->recorded && (res.track != sf->track || res.candidate != sf->candidate)) r->mismatches++;
+        if (track == RECORDER_WRONG_TRACK) {
+            r->wrong_marks++;
+            track = 0;
+        }
+        r->stage_hits[res.stage]++;
+        r->stage_ns[res.stage] += t2 - t1;
+        if (track) dfplayer_build_frame(packet, CMD_PLAY_TRACK, track, false);
+        if (gcfg && governor_update(gov, &f, res.track <= GESTURE_REST, (uint32_t)(now - prev_now))) {
+            flex_filter_set_iir(&filter, clamp_shift(fcfg.iir_shift + governor_setting(gov)->iir_delta));
+        }
+        lat[n_lat] = now_ns() - t0;
+        total += lat[n_lat++];
+
+        if (res.track == GESTURE_UNKNOWN) r->rejected++;
+        if (f.dead_mask) r->degraded++;
+        if (sf->label != LABEL_UNKNOWN) {
+            r->labelled++;
+            if (res.track == sf->label) r->correct++;
+            if (failed && !(track_fingers(m, sf->label) & failed)) {
+                r->spared_labelled++;
+                if (res.track == sf->label) r->spared_correct++;
+            }
+        }
+        if (cfg->samples && res.candidate > 0 && sf->label != LABEL_UNKNOWN && r->n_samples < s->n) {
+            cfg->samples[r->n_samples++] = (replay_sample_t){ res.candidate, sf->label, res.confidence };
+        }
+
+        if (track && track == segment_label && !segment_done) {
+            double latency = now - segment_start;
+            segment_done = true;
+            r->detected++;
+            r->decision_ms += latency;
+            if (latency > r->decision_max_ms) r->decision_max_ms = latency;
+        }
+
+        double gap = 0;
+        if (track) {
+            // A new play command cuts the running clip short
+            double heard = (clip_end < now ? clip_end : now) - clip_start;
+            if (heard > 0) {
+                r->played_ms += heard;
+                if (clip_wrong) r->wasted_ms += heard;
+            }
+            clip_start = now;
+            clip_end = now + clip_ms(cfg, track);
+            clip_wrong = target[k] != LABEL_UNKNOWN && target[k] != track;
+            r->plays++;
+            if (target[k] != LABEL_UNKNOWN) r->scored_plays++;
+            if (clip_wrong) r->false_plays++;
+
+            // play_mp3_file() sleeps DFPLAYER_CMD_GAP_MS, then the loop waits a frame
+            // period; the next frame seen is the logged one nearest to that time
+            if (cfg->player) {
+                dfplayer_emu_write(cfg->player, now, packet, sizeof(packet));
+                if (gcfg) gap = DFPLAYER_CMD_GAP_MS;
+                else asleep_until = now + DFPLAYER_CMD_GAP_MS + REPLAY_FRAME_MS / 2.0;
+            }
+        }
+
+        if (!gcfg) {
+            k++;
+            continue;
+        }
+        // The converter runs through the sleep, or only long enough to fill the next block
+        const governor_setting_t *gs = governor_setting(gov);
+        r->adc_on_ms += gs->adc_paused ? (double)gs->raw_frames * 1000 / RAW_FRAME_HZ + gap : gs->frame_ms + gap;
+        prev_now = now;
+        now += gap + gs->frame_ms;
+    }
+    r->sampled = n_lat;
+    if (!gcfg) r->adc_on_ms = r->session_ms;
+    if (cfg->player) {
+        dfplayer_emu_drain(cfg->player);
+        r->audio = cfg->player->stats;
+    }
+    if (clip_end > clip_start) {
+        r->played_ms += clip_end - clip_start;
+        if (clip_wrong) r->wasted_ms += clip_end - clip_start;
+    }
+
+    if (n_lat) {
+        qsort(lat, n_lat, sizeof(*lat), cmp_u64);
+        r->fps = total ? n_lat * 1e9 / total : 0;
+        r->p50_ns = lat[n_lat / 2];
+        r->p90_ns = lat[n_lat * 90 / 100];
+        r->p99_ns = lat[n_lat * 99 / 100];
+        r->max_ns = lat[n_lat - 1];
+    }
+    free(lat);
+    free(target);
+}
+
+void *replay_load_blob(const char *path, size_t *len) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+
+    void *blob = size > 0 ? aligned_alloc(4, (size + 3) & ~3L) : NULL;
+    if (blob && fread(blob, 1, size, fp) != (size_t)size) {
+        free(blob);
+        blob = NULL;
+    }
+    fclose(fp);
+    *len = blob ? (size_t)size : 0;
+    return blob;
+}
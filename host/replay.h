@@ -0,0 +1,94 @@
+// Frame-by-frame replay of a session through the firmware pipeline:
+// raw ADC frames -> filter bank + health monitor -> gesture_decide -> DFPlayer play command.
+// With a governor the frames are taken at its rate, interpolating between logged frames.
+// A flight recorder dump holds frames as the glove classified them: they go straight
+// to gesture_decide with the recorded dead mask and period, every frame, no governor.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dfplayer_emu.h"
+#include "flex_health.h"
+#include "gesture.h"
+#include "governor.h"
+#include "session.h"
+
+#define REPLAY_FRAME_MS   300     // main loop period of flexsonic.c
+#define REPLAY_DEFAULT_CLIP_MS 2000
+
+// One classified frame with a known label, for calibration
+typedef struct {
+    int16_t candidate;
+    int16_t label;
+    float confidence;
+} replay_sample_t;
+
+typedef enum {
+    REPLAY_FAULT_STUCK,           // constant reading: 0 = disconnected, 4095 = shorted to the supply
+    REPLAY_FAULT_NOISE,           // open input: every sample random
+    REPLAY_FAULT_NONE,            // reference: the sensor keeps working, frames are scored as under a fault
+} replay_fault_kind_t;
+
+// A sensor failure injected into the raw ADC frames
+typedef struct {
+    uint8_t channel;              // 0 = thumb .. 4 = pinky
+    uint8_t kind;                 // replay_fault_kind_t
+    uint16_t value;               // STUCK reading
+    double from_ms;               // session time the sensor fails at
+} replay_fault_t;
+
+typedef struct {
+    const uint32_t *track_ms;     // clip length by track (audio_load_durations), NULL for the default
+    int n_tracks;
+    uint32_t seed;                // ADC noise around the logged values
+    replay_sample_t *samples;     // optional, room for s->n entries (later frames are not kept)
+    dfplayer_emu_t *player;       // optional, online by t = 0: plays go over the emulated UART and
+                                  // the loop sleeps DFPLAYER_CMD_GAP_MS after each, as on the device
+    const replay_fault_t *faults;
+    int n_faults;
+    bool no_health;               // classify with every finger, dead or not (the monitor still runs)
+    const governor_cfg_t *governor;   // optional: frame period, block size and low-pass follow activity
+} replay_cfg_t;
+
+typedef struct {
+    char name[64];
+    size_t frames;
+    double fps;
+    double p50_ns, p90_ns, p99_ns, max_ns;
+    size_t labelled, correct;
+    size_t plays;
+    size_t scored_plays;          // plays made while the intended gesture is known
+    size_t false_plays;           // played a track other than the gesture being made
+    size_t rejected;              // frames held back as GESTURE_UNKNOWN
+    size_t wrong_marks;           // "that was wrong" gestures: the device freezes its recorder, plays nothing
+    size_t mismatches;            // dumps: frames whose track or candidate differs from the glove's
+    double played_ms;             // audio actually heard, cut short by the next play
+    double wasted_ms;             // of which was a wrong clip
+    double session_ms;
+    size_t segments;              // labelled gesture runs (rest excluded)
+    size_t detected;              // of which the right track played
+    double decision_ms;           // summed segment start -> right play
+    double decision_max_ms;
+    size_t stage_hits[GESTURE_STAGES];  // frames settled by each cascade stage
+    double stage_ns[GESTURE_STAGES];    // summed classification time of those frames
+    size_t skipped;               // frames logged while the loop slept after a play command
+    dfplayer_emu_stats_t audio;   // with a player only
+    size_t degraded;              // frames classified with a dead finger left out
+    size_t spared_labelled;       // labelled frames under a fault whose gesture needs no faulty finger
+    size_t spared_correct;
+    flex_health_t health;         // monitor state at the end of the session
+    size_t sampled;               // recognition frames run: wakeups of the frame loop
+    double adc_on_ms;             // converter running; all of session_ms without a governor
+    bool governed;
+    governor_t governor;          // governor state at the end of the session, if one ran
+    size_t n_samples;
+} replay_result_t;
+
+extern const char *const replay_stage_names[GESTURE_STAGES];
+
+void replay_session(const session_t *s, const model_blob_view_t *m, const replay_cfg_t *cfg, replay_result_t *r);
+
+// Read a model blob file into 4-byte aligned memory, as the flash mapping is;
+// NULL if the file is missing, empty or short
+void *replay_load_blob(const char *path, size_t *len);
@@ -0,0 +1,389 @@
+// Replay sessions through a model blob and report what the wearer would hear:
+// false triggers, rejected frames and time lost to wrong clips. With
+// --calibrate, derive per-track thresholds for ml/5_export_model_blob.py. With
+// --dfplayer, plays go through the DFPlayer emulator for audio-path timing.
+// --fault breaks a flex sensor to check the degraded mode. --governor runs the
+// frame loop at the rate the sampling governor picks instead of the logged one.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio.h"
+#include "model_blob.h"
+#include "replay.h"
+#include "session.h"
+#include "session_store.h"
+
+#ifndef FLEXSONIC_ROOT
+#define FLEXSONIC_ROOT ".."
+#endif
+
+#define MAX_SESSIONS 8
+#define MAX_FAULTS FLEX_CHANNELS
+#define RELIABILITY_BINS 10
+
+typedef struct {
+    const char *model_path;
+    const char *audio_dir;
+    const char *json_path;
+    const char *thresholds_path;
+    const char *sessions[MAX_SESSIONS];
+    int n_sessions;
+    double target_precision;      // 0 = no calibration
+    size_t synth_frames;
+    uint32_t seed;
+    bool dfplayer;                // play through the DFPlayer emulator
+    dfplayer_emu_cfg_t player;
+    const char *timeline_path;
+    replay_fault_t faults[MAX_FAULTS];
+    int n_faults;
+    bool no_health;
+    bool governor;
+} replay_args_t;
+
+typedef struct {
+    size_t n, correct;
+    double conf_sum;
+} reliability_bin_t;
+
+static bool ends_with(const char *s, const char *suffix) {
+    size_t ls = strlen(s), lx = strlen(suffix);
+    return ls >= lx && !strcmp(s + ls - lx, suffix);
+}
+
+static int load_session(session_t *s, const char *path, const replay_args_t *args) {
+    if (!strcmp(path, "synthetic")) {
+        session_synth_cfg_t synth = {
+            .frames = args->synth_frames, .seed = args->seed, .noise = 60, .drift = 150, .spike_rate = 0.002,
+        };
+        session_synthesize(s, &synth);
+        return 0;
+    }
+    if (ends_with(path, ".csv")) return session_load_csv(s, path);
+    return ends_with(path, ".frec") ? session_load_recording(s, path) : session_load_log(s, path);
+}
+
+// "finger:stuck:value", "finger:zero", "finger:rail" or "finger:noise", optionally "@ms"
+static bool parse_fault(const char *arg, replay_fault_t *fault) {
+    char finger[16], kind[16];
+    const char *at = strchr(arg, '@');
+    int value = 0;
+
+    memset(fault, 0, sizeof(*fault));
+    if (sscanf(arg, "%15[a-z]:%15[a-z]:%d", finger, kind, &value) < 2) return false;
+    if (at) fault->from_ms = atof(at + 1);
+    fault->channel = FLEX_CHANNELS;
+    for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+        if (!strcmp(finger, flex_channel_names[ch])) fault->channel = ch;
+    }
+    if (!strcmp(kind, "stuck")) fault->value = value < 0 ? 0 : value > 4095 ? 4095 : value;
+    else if (!strcmp(kind, "zero")) fault->value = 0;
+    else if (!strcmp(kind, "rail")) fault->value = 4095;
+    else if (!strcmp(kind, "noise")) fault->kind = REPLAY_FAULT_NOISE;
+    else if (!strcmp(kind, "none")) fault->kind = REPLAY_FAULT_NONE;
+    else return false;
+    return fault->channel < FLEX_CHANNELS;
+}
+
+typedef struct {
+    const replay_args_t *args;
+    const uint32_t *track_ms;
+    const model_blob_view_t *model;
+    replay_result_t *rep;
+    int n_rep;
+    replay_sample_t *samples;
+    size_t n_samples;
+    FILE *timeline;
+} replay_ctx_t;
+
+// Replay one session, keep its result and calibration samples, then free it
+static void replay_one(replay_ctx_t *ctx, session_t *s) {
+    ctx->rep = realloc(ctx->rep, (ctx->n_rep + 1) * sizeof(*ctx->rep));
+    ctx->samples = realloc(ctx->samples, (ctx->n_samples + s->n + 1) * sizeof(*ctx->samples));
+    replay_cfg_t cfg = {
+        .track_ms = ctx->track_ms, .n_tracks = AUDIO_MAX_TRACKS,
+        .seed = ctx->args->seed, .samples = ctx->samples + ctx->n_samples,
+        .faults = ctx->args->faults, .n_faults = ctx->args->n_faults, .no_health = ctx->args->no_health,
+    };
+    static const governor_cfg_t governor_cfg = GOVERNOR_DEFAULTS;
+    if (ctx->args->governor) cfg.governor = &governor_cfg;
+    replay_result_t *r = &ctx->rep[ctx->n_rep++];
+    dfplayer_emu_t player;
+    if (ctx->args->dfplayer) {
+        // Powered on with the glove, so it is online when the session starts
+        dfplayer_emu_cfg_t pcfg = ctx->args->player;
+        pcfg.track_ms = ctx->track_ms;
+        pcfg.n_tracks = AUDIO_MAX_TRACKS;
+        dfplayer_emu_init(&player, &pcfg, -pcfg.boot_ms);
+        cfg.player = &player;
+    }
+    replay_session(s, ctx->model, &cfg, r);
+    ctx->n_samples += r->n_samples;
+
+    fprintf(stderr, "%-24s %7zu frames  %5zu plays  %4zu false (%5.1f%%)  %6zu rejected  %7.1f s wasted of %.1f s\n",
+            r->name, r->frames, r->plays, r->false_plays,
+            r->scored_plays ? 100.0 * r->false_plays / r->scored_plays : 0.0,
+            r->rejected, r->wasted_ms / 1000, r->played_ms / 1000);
+    if (cfg.player) {
+        const dfplayer_emu_stats_t *a = &r->audio;
+        fprintf(stderr, "%-24s audio %5zu plays  %4zu dropped  latency %4.0f ms mean %4.0f max  gap %4.0f ms  %6zu frames asleep\n",
+                "", a->plays, a->dropped, a->started ? a->latency_ms / a->started : 0.0, a->latency_max_ms,
+                a->gaps ? a->gap_ms / a->gaps : 0.0, r->skipped);
+        if (ctx->timeline) {
+            fprintf(ctx->timeline, "# %s\n", r->name);
+            dfplayer_emu_print_timeline(&player, 0, ctx->timeline);
+        }
+        dfplayer_emu_free(&player);
+    }
+    if (s->recorded) {
+        fprintf(stderr, "%-24s %zu of %zu frames decided differently than on the glove\n", "", r->mismatches, r->frames);
+    }
+    if (r->health.dead_mask || cfg.n_faults) {
+        char line[288];
+        flex_health_format(&r->health, line, sizeof(line));
+        fprintf(stderr, "%-24s health %s  %zu frames degraded", "", line, r->degraded);
+        if (r->spared_labelled) {
+            fprintf(stderr, ", accuracy %.1f%% on gestures without a faulty finger",
+                    100.0 * r->spared_correct / r->spared_labelled);
+        }
+        fputc('\n', stderr);
+    }
+    if (r->governed) {
+        char line[160];
+        governor_format(&r->governor, line, sizeof(line));
+        fprintf(stderr, "%-24s governor %s  %zu frames  adc on %.0f%%\n", "", line, r->sampled,
+                r->session_ms > 0 ? 100 * r->adc_on_ms / r->session_ms : 0.0);
+    }
+    session_free(s);
+}
+
+// ------------------- CALIBRATION -------------------
+static int cmp_conf_desc(const void *a, const void *b) {
+    float x = ((const replay_sample_t *)a)->confidence, y = ((const replay_sample_t *)b)->confidence;
+    return x > y ? -1 : x < y;
+}
+
+// Lowest threshold whose accepted frames still reach the target precision, 1 if none does
+static float calibrate_track(replay_sample_t *samples, size_t n, int track, double target) {
+    size_t accepted = 0, correct = 0;
+    float threshold = 1.0f;
+
+    qsort(samples, n, sizeof(*samples), cmp_conf_desc);
+    for (size_t i = 0; i < n; i++) {
+        if (samples[i].candidate != track) continue;
+        accepted++;
+        if (samples[i].label == track) correct++;
+        // Only cut between distinct confidences
+        bool last_of_value = i + 1 == n || samples[i + 1].confidence != samples[i].confidence;
+        if (last_of_value && (double)correct / accepted >= target) threshold = samples[i].confidence;
+    }
+    return threshold;
+}
+
+static void reliability(const replay_sample_t *samples, size_t n, reliability_bin_t bins[RELIABILITY_BINS]) {
+    memset(bins, 0, RELIABILITY_BINS * sizeof(bins[0]));
+    for (size_t i = 0; i < n; i++) {
+        int b = (int)(samples[i].confidence * RELIABILITY_BINS);
+        if (b >= RELIABILITY_BINS) b = RELIABILITY_BINS - 1;
+        bins[b].n++;
+        bins[b].correct += samples[i].candidate == samples[i].label;
+        bins[b].conf_sum += samples[i].confidence;
+    }
+}
+
+// ------------------- OUTPUT -------------------
+static void write_session(FILE *out, const replay_result_t *r, bool audio, bool last) {
+    fprintf(out, "    {\"name\": \"%s\", \"frames\": %zu, \"session_s\": %.1f, \"labelled\": %zu, "
+            "\"accuracy\": %.4f, \"plays\": %zu, \"scored_plays\": %zu, \"false_plays\": %zu, \"false_trigger_rate\": %.4f, "
+            "\"wrong_marks\": %zu, \"mismatches\": %zu, \"rejected\": %zu, \"rejected_rate\": %.4f, \"played_s\": %.1f, \"wasted_s\": %.1f, "
+            "\"wasted_per_min_s\": %.2f, \"segments\": %zu, \"detected\": %zu, \"decision_ms\": %.0f, "
+            "\"decision_max_ms\": %.0f, \"frame_ns\": {\"p50\": %.0f, \"p99\": %.0f}",
+            r->name, r->frames, r->session_ms / 1000, r->labelled,
+            r->labelled ? (double)r->correct / r->labelled : 0.0, r->plays, r->scored_plays, r->false_plays,
+            r->scored_plays ? (double)r->false_plays / r->scored_plays : 0.0,
+            r->wrong_marks, r->mismatches, r->rejected, r->governed ? (double)r->rejected / (r->sampled ? r->sampled : 1)
+                                     : r->frames ? (double)r->rejected / r->frames : 0.0,
+            r->played_ms / 1000, r->wasted_ms / 1000,
+            r->session_ms > 0 ? r->wasted_ms / (r->session_ms / 60000) / 1000 : 0.0,
+            r->segments, r->detected, r->detected ? r->decision_ms / r->detected : 0.0, r->decision_max_ms,
+            r->p50_ns, r->p99_ns);
+    fprintf(out, ", \"stages\": {");
+    for (int k = 0; k < GESTURE_STAGES; k++) {
+        size_t n = r->stage_hits[k];
+        fprintf(out, "%s\"%s\": {\"hit_rate\": %.4f, \"ns\": %.0f}", k ? ", " : "", replay_stage_names[k],
+                r->sampled ? (double)n / r->sampled : 0.0, n ? r->stage_ns[k] / n : 0.0);
+    }
+    fprintf(out, "}, \"health\": {\"dead_mask\": %u, \"degraded\": %zu, \"spared_labelled\": %zu, "
+            "\"spared_accuracy\": %.4f, \"channels\": {",
+            r->health.dead_mask, r->degraded, r->spared_labelled,
+            r->spared_labelled ? (double)r->spared_correct / r->spared_labelled : 0.0);
+    for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+        const flex_health_channel_t *c = &r->health.ch[ch];
+        fprintf(out, "%s\"%s\": {\"state\": %u, \"fault\": \"%s\", \"mean\": %u, \"sd\": %u, \"noise\": %u, "
+                "\"rail_hits\": %lu}", ch ? ", " : "", flex_channel_names[ch], c->state, flex_fault_names[c->fault],
+                c->mean, c->sd, c->noise, (unsigned long)c->rail_hits);
+    }
+    fprintf(out, "}}");
+    if (r->governed) {
+        const governor_t *g = &r->governor;
+        double total = 0;
+        for (int l = 0; l < GOVERNOR_LEVELS; l++) total += g->level_ms[l];
+        fprintf(out, ", \"governor\": {\"sampled\": %zu, \"frames_per_s\": %.2f, \"adc_on_share\": %.4f, "
+                "\"switches\": %lu", r->sampled, r->session_ms > 0 ? r->sampled * 1000 / r->session_ms : 0.0,
+                r->session_ms > 0 ? r->adc_on_ms / r->session_ms : 0.0, (unsigned long)g->switches);
+        for (int l = 0; l < GOVERNOR_LEVELS; l++) {
+            fprintf(out, ", \"%s_share\": %.4f", governor_level_names[l], total > 0 ? g->level_ms[l] / total : 0.0);
+        }
+        fprintf(out, "}");
+    }
+    if (audio) {
+        const dfplayer_emu_stats_t *a = &r->audio;
+        fprintf(out, ", \"skipped\": %zu, \"audio\": {\"plays\": %zu, \"dropped\": %zu, \"bad_frames\": %zu, "
+                "\"cut\": %zu, \"heard_s\": %.1f, \"latency_ms\": %.1f, \"latency_max_ms\": %.1f, \"gap_ms\": %.1f}",
+                r->skipped, a->plays, a->dropped, a->bad_frames, a->cut, a->heard_ms / 1000,
+                a->started ? a->latency_ms / a->started : 0.0, a->latency_max_ms, a->gaps ? a->gap_ms / a->gaps : 0.0);
+    }
+    fprintf(out, "}%s\n", last ? "" : ",");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s --model blob.bin [--session log|csv|store.fses|dump.frec|synthetic]... [--audio dir] [--json out.json]\n"
+            "       [--calibrate target_precision] [--thresholds out.json] [--synthetic-frames N] [--seed S]\n"
+            "       [--dfplayer] [--dfplayer-latency decode,start,ack] [--timeline out.txt]\n"
+            "       [--fault finger:stuck:N|zero|rail|noise|none[@ms]]... [--no-health] [--governor]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    replay_args_t args = {
+        .audio_dir = FLEXSONIC_ROOT "/audio", .synth_frames = 20000, .seed = 42, .player = DFPLAYER_EMU_DEFAULTS,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--model") && i + 1 < argc) args.model_path = argv[++i];
+        else if (!strcmp(argv[i], "--session") && i + 1 < argc && args.n_sessions < MAX_SESSIONS) args.sessions[args.n_sessions++] = argv[++i];
+        else if (!strcmp(argv[i], "--audio") && i + 1 < argc) args.audio_dir = argv[++i];
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc) args.json_path = argv[++i];
+        else if (!strcmp(argv[i], "--calibrate") && i + 1 < argc) args.target_precision = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--thresholds") && i + 1 < argc) args.thresholds_path = argv[++i];
+        else if (!strcmp(argv[i], "--synthetic-frames") && i + 1 < argc) args.synth_frames = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) args.seed = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--dfplayer")) args.dfplayer = true;
+        else if (!strcmp(argv[i], "--dfplayer-latency") && i + 1 < argc) {
+            args.dfplayer = true;
+            sscanf(argv[++i], "%lf,%lf,%lf", &args.player.decode_ms, &args.player.start_ms, &args.player.ack_ms);
+        }
+        else if (!strcmp(argv[i], "--timeline") && i + 1 < argc) {
+            args.dfplayer = true;
+            args.timeline_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--fault") && i + 1 < argc && args.n_faults < MAX_FAULTS) {
+            if (!parse_fault(argv[++i], &args.faults[args.n_faults++])) usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--no-health")) args.no_health = true;
+        else if (!strcmp(argv[i], "--governor")) args.governor = true;
+        else usage(argv[0]);
+    }
+    if (!args.model_path) usage(argv[0]);
+    if (args.n_sessions == 0) {
+        args.sessions[args.n_sessions++] = FLEXSONIC_ROOT "/data processed/gesture_labeled.csv";
+        args.sessions[args.n_sessions++] = "synthetic";
+    }
+
+    size_t model_len;
+    void *blob = replay_load_blob(args.model_path, &model_len);
+    model_blob_view_t model;
+    if (!blob || !model_blob_parse(blob, model_len, &model)) {
+        fprintf(stderr, "invalid model blob %s\n", args.model_path);
+        return 1;
+    }
+
+    static uint32_t track_ms[AUDIO_MAX_TRACKS];
+    int n_clips = audio_load_durations(args.audio_dir, track_ms);
+    if (n_clips == 0) fprintf(stderr, "no clips in %s, assuming %d ms each\n", args.audio_dir, REPLAY_DEFAULT_CLIP_MS);
+
+    replay_ctx_t ctx = { .args = &args, .track_ms = n_clips ? track_ms : NULL, .model = &model };
+    if (args.timeline_path && !(ctx.timeline = fopen(args.timeline_path, "w"))) {
+        perror(args.timeline_path);
+        return 1;
+    }
+    for (int i = 0; i < args.n_sessions; i++) {
+        const char *path = args.sessions[i];
+        if (ends_with(path, ".fses")) {
+            // Every session of a store, straight from the mapped columns
+            session_store_t st;
+            if (session_store_open(&st, path) != 0) {
+                fprintf(stderr, "cannot open store %s\n", path);
+                continue;
+            }
+            for (size_t k = 0; k < st.n_sessions; k++) {
+                session_t s;
+                if (session_store_load(&st, k, &s) == 0) replay_one(&ctx, &s);
+            }
+            session_store_close(&st);
+            continue;
+        }
+        session_t s = { 0 };
+        if (load_session(&s, path, &args) != 0) {
+            fprintf(stderr, "cannot load %s\n", path);
+            continue;
+        }
+        replay_one(&ctx, &s);
+    }
+    if (ctx.timeline) fclose(ctx.timeline);
+    replay_result_t *rep = ctx.rep;
+    replay_sample_t *samples = ctx.samples;
+    size_t n_samples = ctx.n_samples;
+    int n_rep = ctx.n_rep;
+
+    FILE *out = args.json_path ? fopen(args.json_path, "w") : stdout;
+    if (!out) {
+        perror(args.json_path);
+        return 1;
+    }
+    fprintf(out, "{\n  \"model_generation\": %u,\n  \"clips\": %d,\n  \"sessions\": [\n",
+            model.header->generation, n_clips);
+    for (int i = 0; i < n_rep; i++) write_session(out, &rep[i], args.dfplayer, i + 1 == n_rep);
+    fprintf(out, "  ]");
+
+    if (args.target_precision > 0) {
+        reliability_bin_t bins[RELIABILITY_BINS];
+        reliability(samples, n_samples, bins);
+        double ece = 0;
+        fprintf(out, ",\n  \"reliability\": [\n");
+        for (int b = 0; b < RELIABILITY_BINS; b++) {
+            double acc = bins[b].n ? (double)bins[b].correct / bins[b].n : 0;
+            double conf = bins[b].n ? bins[b].conf_sum / bins[b].n : 0;
+            ece += n_samples ? fabs(acc - conf) * bins[b].n / n_samples : 0;
+            fprintf(out, "    {\"lo\": %.1f, \"frames\": %zu, \"mean_confidence\": %.3f, \"accuracy\": %.3f}%s\n",
+                    (double)b / RELIABILITY_BINS, bins[b].n, conf, acc, b + 1 < RELIABILITY_BINS ? "," : "");
+        }
+        fprintf(out, "  ],\n  \"ece\": %.4f,\n  \"thresholds\": {", ece);
+
+        FILE *th = args.thresholds_path ? fopen(args.thresholds_path, "w") : NULL;
+        if (th) fprintf(th, "{");
+        bool first = true;
+        for (int t = 1; t < AUDIO_MAX_TRACKS; t++) {
+            bool seen = false;
+            for (size_t i = 0; i < n_samples && !seen; i++) seen = samples[i].candidate == t;
+            if (!seen) continue;
+            float threshold = calibrate_track(samples, n_samples, t, args.target_precision);
+            fprintf(out, "%s\"%d\": %.3f", first ? "" : ", ", t, threshold);
+            if (th) fprintf(th, "%s\"%d\": %.3f", first ? "" : ", ", t, threshold);
+            first = false;
+        }
+        fprintf(out, "}");
+        if (th) {
+            fprintf(th, "}\n");
+            fclose(th);
+        }
+    }
+    fprintf(out, "\n}\n");
+    if (out != stdout) fclose(out);
+
+    free(samples);
+    free(rep);
+    free(blob);
+    return 0;
+}
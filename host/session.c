@@ -0,0 +1,304 @@
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "recorder.h"
+#include "session.h"
+
+static const struct {
+    const char *gesture;
+    int track;
+} label_tracks[] = {
+    { "rest", 0 },
+    { "thumb_bent", 1 },
+    { "index_bent", 2 },
+    { "middle_bent", 3 },
+    { "ring_bent", 4 },
+    { "pinky_bent", 5 },
+    { "all_bent", 6 },
+};
+
+int session_label_track(const char *gesture) {
+    for (size_t i = 0; i < sizeof(label_tracks) / sizeof(label_tracks[0]); i++) {
+        if (strcmp(label_tracks[i].gesture, gesture) == 0) return label_tracks[i].track;
+    }
+    return LABEL_UNKNOWN;
+}
+
+static session_frame_t *session_push(session_t *s) {
+    if (s->n == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 1024;
+        s->frames = realloc(s->frames, s->cap * sizeof(*s->frames));
+        if (!s->frames) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    session_frame_t *f = &s->frames[s->n++];
+    memset(f, 0, sizeof(*f));
+    f->label = LABEL_UNKNOWN;
+    return f;
+}
+
+static void session_name(session_t *s, const char *path) {
+    const char *base = strrchr(path, '/');
+    snprintf(s->name, sizeof(s->name), "%.63s", base ? base + 1 : path);
+}
+
+// Frames of a dump, times from its first frame
+int session_load_dump(session_t *s, const void *buf, size_t len, const char *name) {
+    const recorder_dump_header_t *h;
+    const recorder_frame_t *rf;
+
+    if (!recorder_parse(buf, len, &h, &rf)) return -1;
+    const char *base = strrchr(name, '/');
+    snprintf(s->name, sizeof(s->name), "%.48s:%s", base ? base + 1 : name,
+             h->trigger < RECORDER_TRIGGERS ? recorder_trigger_names[h->trigger] : "?");
+    s->recorded = true;
+    for (uint32_t i = 0; i < h->n_frames; i++) {
+        session_frame_t *f = session_push(s);
+        f->t_ms = rf[i].t_ms - rf[0].t_ms;
+        memcpy(f->flex, rf[i].flex, sizeof(f->flex));
+        memcpy(f->gyro, rf[i].gyro, sizeof(f->gyro));
+        f->track = rf[i].track;
+        f->candidate = rf[i].candidate;
+        f->dead_mask = rf[i].dead_mask;
+        // A frame records the level chosen after it: it was sampled at the one before
+        f->level = rf[i ? i - 1 : 0].level;
+    }
+    return 0;
+}
+
+int session_load_recording(session_t *s, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    rewind(fp);
+
+    // malloc alignment is enough for recorder_parse()
+    void *buf = len > 0 ? malloc(len) : NULL;
+    int rc = buf && fread(buf, 1, len, fp) == (size_t)len ? session_load_dump(s, buf, len, path) : -1;
+    free(buf);
+    fclose(fp);
+    return rc;
+}
+
+// One "FREC ..." line of a streamed dump into buf; returns the new state:
+// 0 outside a dump, 1 inside, 2 complete
+static int dump_line(const char *p, uint8_t **buf, size_t *len, int state) {
+    unsigned n, off;
+    char hex[2 * 64 + 1];
+
+    if (sscanf(p, "FREC BEGIN %u", &n) == 1) {
+        free(*buf);
+        *buf = calloc(1, n ? n : 1);
+        *len = n;
+        return *buf ? 1 : 0;
+    }
+    if (state != 1) return state;
+    if (!strncmp(p, "FREC END", 8)) return 2;
+    if (sscanf(p, "FREC %x %128[0-9a-f]", &off, hex) != 2) return 1;
+    for (size_t i = 0; hex[2 * i] && hex[2 * i + 1] && off + i < *len; i++) {
+        unsigned byte;
+        sscanf(&hex[2 * i], "%2x", &byte);
+        (*buf)[off + i] = byte;
+    }
+    return 1;
+}
+
+int session_load_log(session_t *s, const char *path) {
+    FILE *fp = fopen(path, "r");
+    char line[512];
+    uint8_t *dump = NULL, *last_dump = NULL;
+    size_t dump_len = 0, last_len = 0;
+    int dump_state = 0;
+
+    if (!fp) return -1;
+    session_name(s, path);
+    while (fgets(line, sizeof(line), fp)) {
+        const char *p = strstr(line, "Thumb:");
+        const char *rec = strstr(line, "FREC ");
+        int v[5];
+        unsigned t = 0;
+
+        if (rec) {
+            dump_state = dump_line(rec, &dump, &dump_len, dump_state);
+            if (dump_state == 2) {
+                // Keep the newest complete dump
+                free(last_dump);
+                last_dump = dump;
+                last_len = dump_len;
+                dump = NULL;
+                dump_state = 0;
+            }
+            continue;
+        }
+        if (!p || sscanf(p, "Thumb:%d | Index:%d | Middle:%d | Ring:%d | Pinky:%d",
+                         &v[0], &v[1], &v[2], &v[3], &v[4]) != 5) {
+            continue;
+        }
+        session_frame_t *f = session_push(s);
+        for (int i = 0; i < 5; i++) f->flex[i] = v[i];
+        if (sscanf(line, "I (%u)", &t) == 1) f->t_ms = t;
+
+        const char *g = strstr(line, "Gyro X:");
+        int gx, gy, gz;
+        if (g && sscanf(g, "Gyro X:%d Y:%d Z:%d", &gx, &gy, &gz) == 3) {
+            f->gyro[0] = gx;
+            f->gyro[1] = gy;
+            f->gyro[2] = gz;
+        }
+    }
+    fclose(fp);
+    free(dump);
+    if (last_dump) {
+        size_t logged = s->n;
+        s->n = 0;
+        if (session_load_dump(s, last_dump, last_len, path) != 0) {
+            fprintf(stderr, "%s: flight recorder dump fails its CRC, using the logged frames\n", path);
+            s->n = logged;
+        }
+        free(last_dump);
+    }
+    return 0;
+}
+
+// Column index of the first header name matching any alias, -1 if absent
+static int csv_column(char **cols, int n, const char *const *aliases) {
+    for (const char *const *a = aliases; *a; a++) {
+        for (int i = 0; i < n; i++) {
+            if (strcasecmp(cols[i], *a) == 0) return i;
+        }
+    }
+    return -1;
+}
+
+static int csv_split(char *line, char **cols, int max) {
+    int n = 0;
+    char *save;
+    for (char *tok = strtok_r(line, ",\r\n", &save); tok && n < max; tok = strtok_r(NULL, ",\r\n", &save)) {
+        while (isspace((unsigned char)*tok)) tok++;
+        cols[n++] = tok;
+    }
+    return n;
+}
+
+int session_load_csv(session_t *s, const char *path) {
+    static const char *const flex_names[5][3] = {
+        { "Thumb", "flex1", NULL }, { "Index", "flex2", NULL }, { "Middle", "flex3", NULL },
+        { "Ring", "flex4", NULL }, { "Pinky", "flex5", NULL },
+    };
+    static const char *const gyro_names[3][3] = {
+        { "Gyro_X", "GyroX", NULL }, { "Gyro_Y", "GyroY", NULL }, { "Gyro_Z", "GyroZ", NULL },
+    };
+    static const char *const label_names[] = { "gesture", NULL };
+    FILE *fp = fopen(path, "r");
+    char line[512];
+    char *cols[32];
+    int flex_col[5], gyro_col[3], label_col;
+
+    if (!fp) return -1;
+    if (!fgets(line, sizeof(line), fp)) {
+        fclose(fp);
+        return -1;
+    }
+    session_name(s, path);
+    int n = csv_split(line, cols, 32);
+    for (int i = 0; i < 5; i++) flex_col[i] = csv_column(cols, n, flex_names[i]);
+    for (int i = 0; i < 3; i++) gyro_col[i] = csv_column(cols, n, gyro_names[i]);
+    label_col = csv_column(cols, n, label_names);
+
+    uint32_t t = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        n = csv_split(line, cols, 32);
+        if (n == 0) continue;
+        session_frame_t *f = session_push(s);
+        f->t_ms = t;
+        t += 300;   // firmware loop period
+        for (int i = 0; i < 5; i++) f->flex[i] = flex_col[i] >= 0 && flex_col[i] < n ? atoi(cols[flex_col[i]]) : 0;
+        for (int i = 0; i < 3; i++) f->gyro[i] = gyro_col[i] >= 0 && gyro_col[i] < n ? atoi(cols[gyro_col[i]]) : 0;
+        if (label_col >= 0 && label_col < n) f->label = session_label_track(cols[label_col]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+// ------------------- SYNTHETIC SESSIONS -------------------
+static uint32_t rng_next(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static double rng_uniform(uint32_t *state) {
+    return (rng_next(state) >> 8) * (1.0 / 16777216.0);
+}
+
+static double rng_gauss(uint32_t *state) {
+    double u = rng_uniform(state) + 1e-12;
+    double v = rng_uniform(state);
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+}
+
+// Per-track hand shapes, roughly the class means of gesture_labeled.csv
+static const int16_t templates[7][5] = {
+    { 0, 0, 0, 0, 0 },               // rest
+    { 2200, 0, 0, 0, 0 },            // thumb_bent
+    { 0, 2250, 0, 0, 0 },            // index_bent
+    { 0, 0, 2850, 0, 0 },            // middle_bent
+    { 0, 0, 0, 3300, 0 },            // ring_bent
+    { 0, 0, 0, 600, 2200 },          // pinky_bent
+    { 3000, 2000, 3600, 4000, 4000 },// all_bent
+};
+
+// ESP32 ADC reads 0 below ~100 mV at 11 dB, hence the exact zeros at rest in data.txt
+#define ADC_DEAD_ZONE 100
+
+static int16_t clamp_adc(double v) {
+    if (v < ADC_DEAD_ZONE) return 0;
+    if (v > 4095) return 4095;
+    return (int16_t)v;
+}
+
+void session_synthesize(session_t *s, const session_synth_cfg_t *cfg) {
+    uint32_t rng = cfg->seed ? cfg->seed : 1;
+    int prev = 0, cur = 0, len = 0, pos = 0;
+    const int transition = 2;
+
+    snprintf(s->name, sizeof(s->name), "synthetic_%zu", cfg->frames);
+    for (size_t k = 0; k < cfg->frames; k++) {
+        if (pos == len) {
+            prev = cur;
+            // Every gesture is followed by a return to rest, like a real signer
+            cur = prev != 0 ? 0 : 1 + (int)(rng_next(&rng) % 6);
+            len = 5 + (int)(rng_next(&rng) % 26);
+            pos = 0;
+        }
+
+        session_frame_t *f = session_push(s);
+        double drift = cfg->drift * ((double)k / cfg->frames);
+        // The first frames of a segment blend from the previous shape and carry no label
+        double blend = pos < transition ? (pos + 1.0) / (transition + 1.0) : 1.0;
+
+        f->t_ms = (uint32_t)(k * 300);
+        f->label = pos < transition ? LABEL_UNKNOWN : cur;
+        for (int i = 0; i < 5; i++) {
+            double v = templates[prev][i] + blend * (templates[cur][i] - templates[prev][i]);
+            v += drift + cfg->noise * rng_gauss(&rng);
+            if (rng_uniform(&rng) < cfg->spike_rate) v = 1000 + rng_uniform(&rng) * 3000;
+            f->flex[i] = clamp_adc(v);
+        }
+        for (int i = 0; i < 3; i++) f->gyro[i] = (int16_t)(-100 + 40 * rng_gauss(&rng));
+        pos++;
+    }
+}
+
+void session_free(session_t *s) {
+    free(s->frames);
+    memset(s, 0, sizeof(*s));
+}
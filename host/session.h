@@ -0,0 +1,60 @@
+// Recorded and synthetic sensor sessions for the host build
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LABEL_UNKNOWN -1   // unlabelled log or transition frame
+
+typedef struct {
+    uint32_t t_ms;
+    int16_t flex[5];       // Thumb, Index, Middle, Ring, Pinky
+    int16_t gyro[3];
+    int16_t label;         // expected track (0 = rest), LABEL_UNKNOWN if not known
+    // Flight recorder dumps only: the glove's own view of the frame
+    int16_t track;         // decision: track, GESTURE_REST or GESTURE_UNKNOWN
+    int16_t candidate;     // best track before the threshold
+    uint8_t dead_mask;
+    uint8_t level;         // governor level the frame was sampled at
+} session_frame_t;
+
+typedef struct {
+    char name[64];
+    session_frame_t *frames;
+    size_t n;
+    size_t cap;
+    bool recorded;         // flight recorder dump: flex already filtered, frames as classified
+} session_t;
+
+typedef struct {
+    size_t frames;
+    uint32_t seed;
+    int noise;             // gaussian sigma on every flex reading, ADC counts
+    int drift;             // baseline offset reached by the end of the session
+    double spike_rate;     // chance per frame of a single-sample jump like data.txt shows
+} session_synth_cfg_t;
+
+// Serial log as written by the firmware ("Thumb:%d | Index:%d ... Gyro X:%d Y:%d Z:%d");
+// a log holding a complete flight recorder dump ("FREC BEGIN" .. "FREC END")
+// loads the last dump instead
+int session_load_log(session_t *s, const char *path);
+
+// Flight recorder dump as saved by the firmware (main/recorder.h), e.g. the
+// recorder partition read back with parttool.py; unlabelled
+int session_load_recording(session_t *s, const char *path);
+
+// Same from memory; name gets ":<trigger>"
+int session_load_dump(session_t *s, const void *buf, size_t len, const char *name);
+
+// CSV from "data processed/" (Thumb.. or flex1.. columns, optional gesture column)
+int session_load_csv(session_t *s, const char *path);
+
+// Long labelled session with noise, drift and spikes
+void session_synthesize(session_t *s, const session_synth_cfg_t *cfg);
+
+void session_free(session_t *s);
+
+// Gesture name used by ml/2_gesture_label.py -> track of 3_predict_and_audio.py
+int session_label_track(const char *gesture);
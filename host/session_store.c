@@ -0,0 +1,125 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "session_store.h"
+
+#define STORE_VERSION     1
+#define HEADER_SIZE       64
+#define COLUMN_ENTRY_SIZE 32
+#define INDEX_ENTRY_SIZE  96
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t n_columns;
+    uint64_t n_frames;
+    uint64_t n_sessions;
+    uint64_t column_dir_offset;
+    uint64_t index_offset;
+} __attribute__((packed)) store_header_t;
+
+typedef struct {
+    char name[16];
+    char dtype[4];
+    uint64_t offset;
+    uint32_t reserved;
+} __attribute__((packed)) store_column_t;
+
+typedef struct {
+    char name[64];
+    uint64_t first;
+    uint64_t count;
+    uint32_t source;
+} __attribute__((packed)) store_index_t;
+
+static const char *const flex_columns[5] = { "thumb", "index", "middle", "ring", "pinky" };
+static const char *const gyro_columns[3] = { "gyro_x", "gyro_y", "gyro_z" };
+
+// Column by name, checked for type and bounds; NULL if absent
+static const void *store_column(const session_store_t *st, const store_header_t *h,
+                                const char *name, const char *dtype, size_t item) {
+    const uint8_t *base = st->map;
+    for (uint32_t i = 0; i < h->n_columns; i++) {
+        const store_column_t *c = (const store_column_t *)(base + h->column_dir_offset + i * COLUMN_ENTRY_SIZE);
+        if (strncmp(c->name, name, sizeof(c->name)) != 0) continue;
+        if (strncmp(c->dtype, dtype, sizeof(c->dtype)) != 0) return NULL;
+        if (c->offset + h->n_frames * item > st->map_len) return NULL;
+        return base + c->offset;
+    }
+    return NULL;
+}
+
+int session_store_open(session_store_t *st, const char *path) {
+    struct stat sb;
+    int fd = open(path, O_RDONLY);
+
+    memset(st, 0, sizeof(*st));
+    if (fd < 0) return -1;
+    if (fstat(fd, &sb) != 0 || sb.st_size < HEADER_SIZE) {
+        close(fd);
+        return -1;
+    }
+    st->map_len = sb.st_size;
+    st->map = mmap(NULL, st->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (st->map == MAP_FAILED) {
+        st->map = NULL;
+        return -1;
+    }
+
+    const store_header_t *h = st->map;
+    if (memcmp(h->magic, "FSES", 4) != 0 || h->version != STORE_VERSION || h->header_size != HEADER_SIZE ||
+        h->column_dir_offset + (uint64_t)h->n_columns * COLUMN_ENTRY_SIZE > st->map_len ||
+        h->index_offset + h->n_sessions * INDEX_ENTRY_SIZE > st->map_len) {
+        session_store_close(st);
+        return -1;
+    }
+    st->n_frames = h->n_frames;
+    st->n_sessions = h->n_sessions;
+    st->index = (const uint8_t *)st->map + h->index_offset;
+
+    bool ok = (st->t_ms = store_column(st, h, "t_ms", "<u4", 4)) != NULL;
+    for (int i = 0; i < 5; i++) ok &= (st->flex[i] = store_column(st, h, flex_columns[i], "<i2", 2)) != NULL;
+    for (int i = 0; i < 3; i++) ok &= (st->gyro[i] = store_column(st, h, gyro_columns[i], "<i2", 2)) != NULL;
+    ok &= (st->label = store_column(st, h, "label", "<i2", 2)) != NULL;
+    if (!ok) {
+        session_store_close(st);
+        return -1;
+    }
+    return 0;
+}
+
+int session_store_load(const session_store_t *st, size_t i, session_t *s) {
+    if (i >= st->n_sessions) return -1;
+    const store_index_t *e = (const store_index_t *)(st->index + i * INDEX_ENTRY_SIZE);
+    if (e->first + e->count > st->n_frames) return -1;
+
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%.*s", (int)strnlen(e->name, sizeof(e->name) - 1), e->name);
+    s->n = s->cap = e->count;
+    s->frames = malloc((s->n ? s->n : 1) * sizeof(*s->frames));
+    if (!s->frames) return -1;
+
+    // Column-wise gather: each pass streams one contiguous channel
+    const uint64_t first = e->first;
+    for (size_t k = 0; k < s->n; k++) s->frames[k].t_ms = st->t_ms[first + k];
+    for (int c = 0; c < 5; c++) {
+        for (size_t k = 0; k < s->n; k++) s->frames[k].flex[c] = st->flex[c][first + k];
+    }
+    for (int c = 0; c < 3; c++) {
+        for (size_t k = 0; k < s->n; k++) s->frames[k].gyro[c] = st->gyro[c][first + k];
+    }
+    for (size_t k = 0; k < s->n; k++) s->frames[k].label = st->label[first + k];
+    return 0;
+}
+
+void session_store_close(session_store_t *st) {
+    if (st->map) munmap(st->map, st->map_len);
+    memset(st, 0, sizeof(*st));
+}
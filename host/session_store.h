@@ -0,0 +1,28 @@
+// Read-only, memory-mapped view of a .fses columnar session store (format in ml/session_store.py)
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "session.h"
+
+#define SESSION_STORE_MAGIC 0x53455346u  // "FSES"
+
+typedef struct {
+    void *map;
+    size_t map_len;
+    uint64_t n_frames;
+    uint64_t n_sessions;
+    const uint32_t *t_ms;
+    const int16_t *flex[5];
+    const int16_t *gyro[3];
+    const int16_t *label;
+    const uint8_t *index;        // n_sessions entries of the session index
+} session_store_t;
+
+int session_store_open(session_store_t *st, const char *path);
+
+// Copy session i out of the mapped columns into frame rows; no text parsing
+int session_store_load(const session_store_t *st, size_t i, session_t *s);
+
+void session_store_close(session_store_t *st);
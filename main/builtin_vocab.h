@@ -0,0 +1,15 @@
+// Generated by ml/5_export_model_blob.py --vocab sentence --header, do not edit
+// Vocabulary used when no valid blob is flashed, first match wins
+
+#pragma once
+
+#include "model_blob.h"
+
+static const model_rule_t builtin_rules[] = {
+    { .track = 23, .flex_mask = FINGER_INDEX, .flags = 0, .flex_lo = 1000, .flex_hi = 3500, .gyro_x = 0, .gyro_y = 0, .gyro_z = 0, .min_conf = 350 },
+    { .track = 5, .flex_mask = FINGER_THUMB, .flags = 0, .flex_lo = 1000, .flex_hi = 3500, .gyro_x = 0, .gyro_y = 0, .gyro_z = 0, .min_conf = 350 },
+    { .track = 7, .flex_mask = FINGER_MIDDLE, .flags = 0, .flex_lo = 1000, .flex_hi = 3500, .gyro_x = 0, .gyro_y = 0, .gyro_z = 0, .min_conf = 350 },
+    { .track = 8, .flex_mask = FINGER_RING, .flags = 0, .flex_lo = 1000, .flex_hi = 3500, .gyro_x = 0, .gyro_y = 0, .gyro_z = 0, .min_conf = 350 },
+    { .track = 25, .flex_mask = FINGER_PINKY, .flags = 0, .flex_lo = 1000, .flex_hi = 3500, .gyro_x = 0, .gyro_y = 0, .gyro_z = 0, .min_conf = 350 },
+    { .track = 6, .flex_mask = 0, .flags = MODEL_RULE_GYRO | MODEL_RULE_REARM, .flex_lo = 400, .flex_hi = 3500, .gyro_x = 1000, .gyro_y = 15000, .gyro_z = 15000, .min_conf = 350 },
+};
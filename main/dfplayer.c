@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "driver/gpio.h"
+#include "dfplayer.h"
+
+// DFPlayer UART
+#define UART_NUM UART_NUM_1
+#define TXD_PIN GPIO_NUM_25   // ESP32 TX → DFPlayer RX (via voltage divider)
+#define RXD_PIN GPIO_NUM_26   // ESP32 RX ← DFPlayer TX
+
+#define DFPLAYER_VOLUME         25    // 0..30
+#define DFPLAYER_QUERY_AFTER_MS 500   // no power-on frame (warm reset), ask instead
+#define DFPLAYER_ONLINE_TIMEOUT_MS 3000
+
+static const char *TAG = "DFPLAYER";
+
+static int64_t last_write_us = -1;   // last frame sent, -1 before the first
+
+static void dfplayer_write(uint8_t cmd, uint16_t param) {
+    uint8_t packet[DFPLAYER_FRAME_LEN];
+    dfplayer_build_frame(packet, cmd, param, false);
+    uart_write_bytes(UART_NUM, (const char *)packet, sizeof(packet));
+    last_write_us = esp_timer_get_time();
+}
+
+// Sleep out what is left of DFPLAYER_CMD_GAP_MS since the last frame sent
+static void dfplayer_wait_gap(void) {
+    if (last_write_us < 0) return;
+    int64_t left_ms = DFPLAYER_CMD_GAP_MS - (esp_timer_get_time() - last_write_us) / 1000;
+    if (left_ms > 0) vTaskDelay(pdMS_TO_TICKS(left_ms));
+}
+
+// Poll the RX line until the module reports its storage online
+static esp_err_t dfplayer_wait_online(void) {
+    uint8_t buf[64];
+    size_t len = 0;
+    bool queried = false;
+    int64_t start = esp_timer_get_time();
+
+    while (1) {
+        int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+        if (elapsed_ms > DFPLAYER_ONLINE_TIMEOUT_MS) return ESP_ERR_TIMEOUT;
+        if (!queried && elapsed_ms > DFPLAYER_QUERY_AFTER_MS) {
+            dfplayer_write(CMD_ONLINE, 0);
+            queried = true;
+        }
+
+        int n = uart_read_bytes(UART_NUM, buf + len, sizeof(buf) - len, pdMS_TO_TICKS(10));
+        if (n > 0) len += n;
+
+        size_t used;
+        do {
+            dfplayer_frame_t frame;
+            bool valid;
+            used = dfplayer_parse_frame(buf, len, &frame, &valid);
+            if (valid && frame.cmd == CMD_ONLINE) return ESP_OK;
+            len -= used;
+            memmove(buf, buf + used, len);
+        } while (used > 0);
+
+        if (len == sizeof(buf)) len = 0;
+    }
+}
+
+esp_err_t dfplayer_init(void) {
+    uart_config_t uart_config = {
+        .baud_rate = DFPLAYER_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE
+    };
+    uart_param_config(UART_NUM, &uart_config);
+    uart_set_pin(UART_NUM, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_driver_install(UART_NUM, 1024, 0, 0, NULL, 0);
+
+    esp_err_t err = dfplayer_wait_online();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No online frame from DFPlayer");
+    }
+    // The online query may have gone out just before the reply; the first
+    // play after startup_wait() must not follow the volume too closely either
+    dfplayer_wait_gap();
+    dfplayer_send_command(CMD_SET_VOLUME, DFPLAYER_VOLUME);
+    return err;
+}
+
+void dfplayer_send_command(uint8_t cmd, uint16_t param) {
+    dfplayer_write(cmd, param);
+    vTaskDelay(pdMS_TO_TICKS(DFPLAYER_CMD_GAP_MS));
+}
+
+void play_mp3_file(int file_number) {
+    ESP_LOGI(TAG, "Playing file %04d.mp3", file_number);
+    dfplayer_send_command(CMD_PLAY_TRACK, file_number);
+}
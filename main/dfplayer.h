@@ -0,0 +1,47 @@
+// DFPlayer Mini serial protocol: 7E FF 06 CMD FB PH PL CH CL EF
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DFPLAYER_FRAME_LEN 10
+#define DFPLAYER_BAUD      9600
+#define DFPLAYER_CMD_GAP_MS 200   // sleep after every command, the module drops frames it gets too fast
+
+#define CMD_PLAY_TRACK    0x03
+#define CMD_SET_VOLUME    0x06
+#define CMD_RESET         0x0C
+#define CMD_TRACK_DONE    0x3D  // reply: track finished on SD card
+#define CMD_ONLINE        0x3F  // reply: storage online / query: storage status
+#define CMD_ERROR         0x40
+#define CMD_ACK           0x41
+
+// Parameter of a CMD_ERROR reply
+#define DFPLAYER_ERR_BUSY      0x01   // still initialising
+#define DFPLAYER_ERR_CHECKSUM  0x04
+#define DFPLAYER_ERR_NOT_FOUND 0x06   // no such track
+
+typedef struct {
+    uint8_t cmd;
+    bool feedback;        // sender asks for a CMD_ACK
+    uint16_t param;
+} dfplayer_frame_t;
+
+// Fill out[DFPLAYER_FRAME_LEN] with a command frame
+void dfplayer_build_frame(uint8_t *out, uint8_t cmd, uint16_t param, bool feedback);
+
+// Scan buf for one valid frame; returns bytes consumed (0 = need more data)
+size_t dfplayer_parse_frame(const uint8_t *buf, size_t len, dfplayer_frame_t *frame, bool *valid);
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// UART bring-up; waits for the online frame instead of sleeping
+esp_err_t dfplayer_init(void);
+
+void dfplayer_send_command(uint8_t cmd, uint16_t param);
+void play_mp3_file(int file_number);
+#endif
@@ -0,0 +1,39 @@
+#include "dfplayer.h"
+
+void dfplayer_build_frame(uint8_t *out, uint8_t cmd, uint16_t param, bool feedback) {
+    out[0] = 0x7E;
+    out[1] = 0xFF;
+    out[2] = 0x06;
+    out[3] = cmd;
+    out[4] = feedback ? 0x01 : 0x00;
+    out[5] = (uint8_t)(param >> 8);
+    out[6] = (uint8_t)(param & 0xFF);
+    uint16_t checksum = 0;
+    for (int i = 1; i < 7; i++) checksum += out[i];
+    checksum = -checksum;
+    out[7] = (uint8_t)(checksum >> 8);
+    out[8] = (uint8_t)(checksum & 0xFF);
+    out[9] = 0xEF;
+}
+
+size_t dfplayer_parse_frame(const uint8_t *buf, size_t len, dfplayer_frame_t *frame, bool *valid) {
+    size_t start = 0;
+
+    *valid = false;
+    while (start < len && buf[start] != 0x7E) start++;
+    if (len - start < DFPLAYER_FRAME_LEN) return start;   // drop leading garbage only
+
+    const uint8_t *p = buf + start;
+    if (p[1] != 0xFF || p[2] != 0x06 || p[9] != 0xEF) return start + 1;
+
+    uint16_t checksum = 0;
+    for (int i = 1; i < 7; i++) checksum += p[i];
+    checksum = -checksum;
+    if (p[7] != (uint8_t)(checksum >> 8) || p[8] != (uint8_t)(checksum & 0xFF)) return start + 1;
+
+    frame->cmd = p[3];
+    frame->feedback = p[4] != 0;
+    frame->param = (uint16_t)((p[5] << 8) | p[6]);
+    *valid = true;
+    return start + DFPLAYER_FRAME_LEN;
+}
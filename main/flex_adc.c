@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_adc/adc_continuous.h"
+#include "flex_adc.h"
+
+// Flex Sensor ADC Channels (update to match your wiring)
+#define FLEX1 ADC_CHANNEL_0  // GPIO36 (VP) - Thumb
+#define FLEX2 ADC_CHANNEL_6  // GPIO34 - Index
+#define FLEX3 ADC_CHANNEL_7  // GPIO35 - Middle
+#define FLEX4 ADC_CHANNEL_4  // GPIO32 - Ring
+#define FLEX5 ADC_CHANNEL_5  // GPIO33 - Pinky
+
+#define CONV_FRAME_BYTES 256
+// Twice the largest block: the pool does not fill in the time one block takes
+#define STORE_BUF_BYTES  (2 * FLEX_ADC_MAX_FRAMES * FLEX_CHANNELS * SOC_ADC_DIGI_RESULT_BYTES)
+
+static const char *TAG = "FLEX_ADC";
+
+static const adc_channel_t flex_channels[FLEX_CHANNELS] = { FLEX1, FLEX2, FLEX3, FLEX4, FLEX5 };
+
+static adc_continuous_handle_t adc_handle;
+static int8_t slot_of_channel[8];              // ADC channel -> finger index
+static uint16_t partial[FLEX_CHANNELS];        // frame being assembled across reads
+static uint8_t partial_mask;
+static uint16_t newest[FLEX_ADC_MAX_FRAMES * FLEX_CHANNELS];   // ring of the newest frames read
+
+esp_err_t flex_adc_init(void) {
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = STORE_BUF_BYTES,
+        .conv_frame_size = CONV_FRAME_BYTES,
+    };
+    esp_err_t err = adc_continuous_new_handle(&handle_cfg, &adc_handle);
+    if (err != ESP_OK) return err;
+
+    adc_digi_pattern_config_t pattern[FLEX_CHANNELS];
+    memset(slot_of_channel, -1, sizeof(slot_of_channel));
+    for (int i = 0; i < FLEX_CHANNELS; i++) {
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = flex_channels[i];
+        pattern[i].unit = ADC_UNIT_1;
+        pattern[i].bit_width = ADC_BITWIDTH_12;
+        slot_of_channel[flex_channels[i]] = i;
+    }
+
+    adc_continuous_config_t dig_cfg = {
+        .sample_freq_hz = FLEX_ADC_SAMPLE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+        .pattern_num = FLEX_CHANNELS,
+        .adc_pattern = pattern,
+    };
+    err = adc_continuous_config(adc_handle, &dig_cfg);
+    if (err == ESP_OK) err = adc_continuous_start(adc_handle);
+    if (err != ESP_OK) ESP_LOGE(TAG, "Continuous ADC start failed: %s", esp_err_to_name(err));
+    return err;
+}
+
+int flex_adc_read(uint16_t *frames, int max_frames) {
+    uint8_t buf[CONV_FRAME_BYTES];
+    int n = 0;
+
+    if (max_frames <= 0) return 0;
+    if (max_frames > FLEX_ADC_MAX_FRAMES) max_frames = FLEX_ADC_MAX_FRAMES;
+    while (1) {
+        uint32_t len = 0;
+        if (adc_continuous_read(adc_handle, buf, sizeof(buf), &len, 0) != ESP_OK) break;
+
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&buf[i];
+            int ch = p->type1.channel;
+            if (ch >= 8 || slot_of_channel[ch] < 0) continue;
+
+            // The DMA block can start anywhere in the pattern, so frames are
+            // assembled per channel and emitted once every finger is present
+            int slot = slot_of_channel[ch];
+            partial[slot] = p->type1.data;
+            partial_mask |= 1u << slot;
+            if (partial_mask == (1u << FLEX_CHANNELS) - 1) {
+                memcpy(&newest[(n % max_frames) * FLEX_CHANNELS], partial, sizeof(partial));
+                partial_mask = 0;
+                n++;
+            }
+        }
+    }
+    if (n <= max_frames) {
+        memcpy(frames, newest, n * sizeof(partial));
+        return n;
+    }
+    // Wrapped: the oldest kept frame sits where the next one would have gone
+    int split = n % max_frames;
+    memcpy(frames, &newest[split * FLEX_CHANNELS], (max_frames - split) * sizeof(partial));
+    memcpy(&frames[(max_frames - split) * FLEX_CHANNELS], newest, split * sizeof(partial));
+    return max_frames;
+}
+
+void flex_adc_flush(void) {
+    uint8_t buf[CONV_FRAME_BYTES];
+    uint32_t len;
+
+    while (adc_continuous_read(adc_handle, buf, sizeof(buf), &len, 0) == ESP_OK) {
+    }
+    partial_mask = 0;
+}
+
+esp_err_t flex_adc_pause(void) {
+    return adc_continuous_stop(adc_handle);
+}
+
+esp_err_t flex_adc_resume(void) {
+    esp_err_t err = adc_continuous_start(adc_handle);
+    if (err != ESP_OK) return err;
+    flex_adc_flush();
+    return ESP_OK;
+}
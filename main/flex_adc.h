@@ -0,0 +1,27 @@
+// Flex sensors sampled by ADC1 continuous (DMA) mode, delivered as interleaved frames
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "flex_filter.h"
+
+#define FLEX_ADC_SAMPLE_HZ  20000   // total conversions/s, ESP32 minimum; 4 kHz per finger
+#define FLEX_ADC_MAX_FRAMES 128     // most frames one flex_adc_read() call returns
+#define FLEX_ADC_FRAME_HZ   (FLEX_ADC_SAMPLE_HZ / FLEX_CHANNELS)
+
+esp_err_t flex_adc_init(void);
+
+// Drain everything the DMA has collected and keep the newest max_frames
+// (at most FLEX_ADC_MAX_FRAMES) in frames[k * FLEX_CHANNELS + ch], oldest
+// first (Thumb, Index, Middle, Ring, Pinky); returns the number of whole frames.
+int flex_adc_read(uint16_t *frames, int max_frames);
+
+// Drop what the pool holds, so the next read only sees conversions made
+// after this call. The pool stops taking conversions once full, so a frame
+// loop slower than the pool fills flushes one block's time before reading.
+void flex_adc_flush(void);
+
+// Stop the converter between frames; resume flushes the pool
+esp_err_t flex_adc_pause(void);
+esp_err_t flex_adc_resume(void);
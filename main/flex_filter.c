@@ -0,0 +1,85 @@
+#include <string.h>
+#include "flex_filter.h"
+
+int flex_boxcar(const uint16_t *samples, int n, int stride) {
+    int sum = 0;
+    for (int i = 0; i < n; i++) sum += samples[i * stride];
+    return sum / n;
+}
+
+// ------------------- FILTER BANK -------------------
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// Branch-free median networks, the compiler turns MIN/MAX into min/max instructions
+static inline int median3(int a, int b, int c) {
+    return MAX(MIN(a, b), MIN(MAX(a, b), c));
+}
+
+static inline int median5(int a, int b, int c, int d, int e) {
+    int f = MAX(MIN(a, b), MIN(c, d));
+    int g = MIN(MAX(a, b), MAX(c, d));
+    return median3(e, f, g);
+}
+
+void flex_filter_init(flex_filter_t *f, const flex_filter_cfg_t *cfg) {
+    memset(f, 0, sizeof(*f));
+    f->cfg = *cfg;
+    if (f->cfg.median_n > FLEX_FILTER_MAX_MEDIAN) f->cfg.median_n = FLEX_FILTER_MAX_MEDIAN;
+    if (f->cfg.median_n != 3 && f->cfg.median_n != 5) f->cfg.median_n = 1;
+    if (f->cfg.decimation == 0) f->cfg.decimation = 1;
+}
+
+void flex_filter_set_iir(flex_filter_t *f, uint8_t iir_shift) {
+    f->cfg.iir_shift = iir_shift;
+}
+
+int flex_filter_block(flex_filter_t *f, const uint16_t *in, int n_frames, uint16_t *out) {
+    const int median_n = f->cfg.median_n;
+    const int shift = f->cfg.iir_shift;
+    int n_out = 0;
+
+    for (int k = 0; k < n_frames; k++, in += FLEX_CHANNELS) {
+        int med[FLEX_CHANNELS];
+
+        // Stage 1: median of the last median_n frames rejects single-sample spikes
+        if (median_n > 1) {
+            memcpy(f->hist[f->hist_pos], in, sizeof(f->hist[0]));
+            if (++f->hist_pos == median_n) f->hist_pos = 0;
+            if (f->hist_fill < median_n) f->hist_fill++;
+        }
+        if (median_n == 1 || f->hist_fill < median_n) {
+            for (int ch = 0; ch < FLEX_CHANNELS; ch++) med[ch] = in[ch];
+        } else if (median_n == 3) {
+            for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+                med[ch] = median3(f->hist[0][ch], f->hist[1][ch], f->hist[2][ch]);
+            }
+        } else {
+            for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+                med[ch] = median5(f->hist[0][ch], f->hist[1][ch], f->hist[2][ch],
+                                  f->hist[3][ch], f->hist[4][ch]);
+            }
+        }
+
+        // Stage 2: fixed-point one-pole low-pass, seeded with the first sample
+        if (!f->primed) {
+            for (int ch = 0; ch < FLEX_CHANNELS; ch++) f->iir[ch] = med[ch] << FLEX_IIR_FRAC;
+            f->primed = 1;
+        } else if (shift) {
+            for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+                f->iir[ch] += ((med[ch] << FLEX_IIR_FRAC) - f->iir[ch]) >> shift;
+            }
+        } else {
+            for (int ch = 0; ch < FLEX_CHANNELS; ch++) f->iir[ch] = med[ch] << FLEX_IIR_FRAC;
+        }
+
+        // Stage 3: decimation
+        if (++f->decim_count < f->cfg.decimation) continue;
+        f->decim_count = 0;
+        for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+            out[n_out * FLEX_CHANNELS + ch] = (uint16_t)((f->iir[ch] + (1 << (FLEX_IIR_FRAC - 1))) >> FLEX_IIR_FRAC);
+        }
+        n_out++;
+    }
+    return n_out;
+}
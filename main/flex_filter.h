@@ -0,0 +1,42 @@
+// Flex sensor smoothing kernels, IDF-free so the host build can run them
+
+#pragma once
+
+#include <stdint.h>
+
+#define FLEX_CHANNELS 5
+#define FLEX_FILTER_MAX_MEDIAN 5
+#define FLEX_IIR_FRAC 8   // IIR state is Q8
+
+// Boxcar average of n samples taken every stride entries
+int flex_boxcar(const uint16_t *samples, int n, int stride);
+
+typedef struct {
+    uint8_t median_n;     // spike rejection window: 1 (off), 3 or 5
+    uint8_t iir_shift;    // low-pass y += (x - y) >> shift, 0 = off
+    uint8_t decimation;   // emit one frame every N input frames (0/1 = every frame)
+} flex_filter_cfg_t;
+
+// 4 kHz per finger in: median-of-5 spike rejection, ~1 ms low-pass, 1 kHz out.
+// What the firmware runs unless the model blob brings its own settings.
+#define FLEX_FILTER_DEFAULTS { .median_n = 5, .iir_shift = 2, .decimation = 4 }
+
+// State for all channels; sample history is kept channel-interleaved like the input
+typedef struct {
+    flex_filter_cfg_t cfg;
+    uint16_t hist[FLEX_FILTER_MAX_MEDIAN][FLEX_CHANNELS];
+    int32_t iir[FLEX_CHANNELS];
+    uint8_t hist_pos;
+    uint8_t hist_fill;
+    uint8_t decim_count;
+    uint8_t primed;
+} flex_filter_t;
+
+void flex_filter_init(flex_filter_t *f, const flex_filter_cfg_t *cfg);
+
+// Change the low-pass depth on the fly; history and IIR state carry over
+void flex_filter_set_iir(flex_filter_t *f, uint8_t iir_shift);
+
+// Filter n_frames interleaved frames (in[k * FLEX_CHANNELS + ch]) in one call.
+// Writes the decimated frames to out in the same layout; returns how many.
+int flex_filter_block(flex_filter_t *f, const uint16_t *in, int n_frames, uint16_t *out);
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <string.h>
+#include "flex_health.h"
+
+const char *const flex_channel_names[FLEX_CHANNELS] = { "thumb", "index", "middle", "ring", "pinky" };
+
+const char *const flex_fault_names[FLEX_FAULTS] = {
+    [FLEX_FAULT_NONE] = "none", [FLEX_FAULT_IDLE] = "idle", [FLEX_FAULT_RAIL] = "rail",
+    [FLEX_FAULT_STUCK] = "stuck", [FLEX_FAULT_NOISY] = "noisy",
+};
+
+static const char *const state_names[] = {
+    [FLEX_HEALTH_OK] = "ok", [FLEX_HEALTH_SUSPECT] = "suspect", [FLEX_HEALTH_DEAD] = "dead",
+};
+
+static const uint16_t dead_after[FLEX_FAULTS] = {
+    [FLEX_FAULT_IDLE] = FLEX_HEALTH_IDLE_BLOCKS, [FLEX_FAULT_RAIL] = FLEX_HEALTH_RAIL_BLOCKS,
+    [FLEX_FAULT_STUCK] = FLEX_HEALTH_STUCK_BLOCKS, [FLEX_FAULT_NOISY] = FLEX_HEALTH_NOISY_BLOCKS,
+};
+
+// One channel over one block
+typedef struct {
+    uint32_t sum, steps;
+    uint64_t sum_sq;
+    uint16_t lo, hi;
+    uint16_t rail_lo, rail_hi;
+} block_stats_t;
+
+static uint32_t isqrt(uint32_t x) {
+    uint32_t r = 0, bit = 1u << 30;
+
+    while (bit > x) bit >>= 2;
+    while (bit) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+// Rails first: a finger at 0 is flat as well, but that is a straight finger until proven otherwise
+static flex_fault_t judge(const block_stats_t *b, int n) {
+    if (b->rail_lo * 4 >= n * 3) return FLEX_FAULT_IDLE;
+    if (b->rail_hi * 4 >= n * 3) return FLEX_FAULT_RAIL;
+    if (b->hi - b->lo <= FLEX_HEALTH_STUCK_LSB) return FLEX_FAULT_STUCK;
+    if (b->steps / (n - 1) > FLEX_HEALTH_NOISE_MAX) return FLEX_FAULT_NOISY;
+    return FLEX_FAULT_NONE;
+}
+
+void flex_health_init(flex_health_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+bool flex_health_block(flex_health_t *h, const uint16_t *in, int n_frames) {
+    block_stats_t b[FLEX_CHANNELS];
+    flex_fault_t fault[FLEX_CHANNELS];
+    uint8_t old_mask = h->dead_mask;
+    int moving = 0;
+
+    if (n_frames < FLEX_HEALTH_MIN_SAMPLES) return false;
+    for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+        b[ch] = (block_stats_t){ .lo = UINT16_MAX };
+    }
+    for (int k = 0; k < n_frames; k++, in += FLEX_CHANNELS) {
+        for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+            uint32_t v = in[ch];
+            block_stats_t *s = &b[ch];
+            s->sum += v;
+            s->sum_sq += v * v;
+            if (v < s->lo) s->lo = v;
+            if (v > s->hi) s->hi = v;
+            s->rail_lo += v <= FLEX_HEALTH_RAIL_LO;
+            s->rail_hi += v >= FLEX_HEALTH_RAIL_HI;
+            if (k) s->steps += v > in[ch - FLEX_CHANNELS] ? v - in[ch - FLEX_CHANNELS] : in[ch - FLEX_CHANNELS] - v;
+        }
+    }
+
+    for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+        flex_health_channel_t *c = &h->ch[ch];
+        const block_stats_t *s = &b[ch];
+        uint64_t var = (s->sum_sq - (uint64_t)s->sum * s->sum / n_frames) / n_frames;
+        c->mean = s->sum / n_frames;
+        c->sd = isqrt((uint32_t)var);
+        c->noise += ((int)(s->steps / (n_frames - 1)) - (int)c->noise) / 4;
+        c->rail_hits += s->rail_lo + s->rail_hi;
+        fault[ch] = judge(s, n_frames);
+        if (fault[ch] == FLEX_FAULT_NONE && c->state != FLEX_HEALTH_DEAD) moving++;
+    }
+
+    for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+        flex_health_channel_t *c = &h->ch[ch];
+        if (fault[ch] == FLEX_FAULT_NONE) {
+            c->bad_blocks = 0;
+            if (c->state != FLEX_HEALTH_DEAD) {
+                c->state = FLEX_HEALTH_OK;
+                continue;
+            }
+            bool at_rail = c->fault == FLEX_FAULT_IDLE || c->fault == FLEX_FAULT_RAIL;
+            if (++c->good_blocks >= (at_rail ? 1 : FLEX_HEALTH_RECOVER_BLOCKS)) {
+                c->state = FLEX_HEALTH_OK;
+                c->fault = FLEX_FAULT_NONE;
+                h->dead_mask &= ~(1u << ch);
+            }
+            continue;
+        }
+
+        // An open hand says nothing about one finger at 0
+        if (fault[ch] == FLEX_FAULT_IDLE && moving == 0) continue;
+        if (c->state == FLEX_HEALTH_DEAD) {
+            c->good_blocks = 0;
+            continue;
+        }
+        c->fault = fault[ch];
+        if (c->bad_blocks < UINT16_MAX) c->bad_blocks++;
+        if (c->bad_blocks < dead_after[c->fault]) {
+            // A finger at 0 is a straight finger until it has been idle for long
+            c->state = c->fault == FLEX_FAULT_IDLE ? FLEX_HEALTH_OK : FLEX_HEALTH_SUSPECT;
+            continue;
+        }
+        c->state = FLEX_HEALTH_DEAD;
+        c->dead_at = c->mean;
+        c->good_blocks = 0;
+        h->dead_mask |= 1u << ch;
+    }
+    h->blocks++;
+    return h->dead_mask != old_mask;
+}
+
+int flex_health_format(const flex_health_t *h, char *buf, size_t len) {
+    int pos = 0;
+
+    buf[0] = '\0';
+    for (int ch = 0; ch < FLEX_CHANNELS && pos < (int)len; ch++) {
+        const flex_health_channel_t *c = &h->ch[ch];
+        char state[24];
+        if (c->state == FLEX_HEALTH_OK) {
+            snprintf(state, sizeof(state), "%s", state_names[c->state]);
+        } else {
+            snprintf(state, sizeof(state), "%s(%s)", state_names[c->state], flex_fault_names[c->fault]);
+        }
+        pos += snprintf(buf + pos, len - pos, "%s%s=%s/%u/%u/%u/%lu", ch ? "," : "", flex_channel_names[ch], state,
+                        c->mean, c->sd, c->noise, (unsigned long)c->rail_hits);
+    }
+    return pos < (int)len ? pos : (int)len - 1;
+}
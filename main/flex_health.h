@@ -0,0 +1,71 @@
+// Per-channel health of the flex sensors, judged on every raw DMA block. A
+// disconnected, shorted or cracked sensor is declared dead and left out of
+// recognition until it reads like a sensor again. IDF-free for the host build.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "flex_filter.h"
+
+#define FLEX_HEALTH_MIN_SAMPLES 16     // smaller blocks are not judged
+#define FLEX_HEALTH_RAIL_LO     16     // at or below: low rail, where a straight finger sits too
+#define FLEX_HEALTH_RAIL_HI     4079   // at or above: full scale
+#define FLEX_HEALTH_STUCK_LSB   1      // a live channel spans more than this within a block
+#define FLEX_HEALTH_NOISE_MAX   400    // mean step between samples above this: open input
+
+// Faulty blocks in a row (one per frame) before a channel is declared dead
+#define FLEX_HEALTH_STUCK_BLOCKS 10    // flat off the rails: shorted sensor or broken ADC path
+#define FLEX_HEALTH_NOISY_BLOCKS 5     // floating input picking up noise
+#define FLEX_HEALTH_RAIL_BLOCKS  100   // pinned at full scale for 30 s
+#define FLEX_HEALTH_IDLE_BLOCKS  1000  // flat at 0 for 5 min while other fingers moved
+
+// Clean blocks in a row that bring a stuck or noisy channel back; a channel
+// that died at a rail is back as soon as it leaves it
+#define FLEX_HEALTH_RECOVER_BLOCKS 10
+
+typedef enum {
+    FLEX_FAULT_NONE,
+    FLEX_FAULT_IDLE,      // at the low rail (only counted while another finger moves)
+    FLEX_FAULT_RAIL,      // at full scale
+    FLEX_FAULT_STUCK,
+    FLEX_FAULT_NOISY,
+    FLEX_FAULTS,
+} flex_fault_t;
+
+typedef enum {
+    FLEX_HEALTH_OK,
+    FLEX_HEALTH_SUSPECT,  // stuck, pinned or noisy blocks seen, still used for recognition
+    FLEX_HEALTH_DEAD,
+} flex_health_state_t;
+
+typedef struct {
+    uint16_t mean;        // last judged block
+    uint16_t sd;          // standard deviation within it: movement plus noise
+    uint16_t noise;       // noise floor: mean step between samples, averaged over blocks
+    uint16_t dead_at;     // block mean when the channel died
+    uint32_t rail_hits;   // samples at either rail since init
+    uint16_t bad_blocks;  // faulty blocks in a row
+    uint16_t good_blocks; // clean blocks in a row while dead
+    uint8_t fault;        // flex_fault_t of the last faulty block
+    uint8_t state;        // flex_health_state_t
+} flex_health_channel_t;
+
+typedef struct {
+    flex_health_channel_t ch[FLEX_CHANNELS];
+    uint8_t dead_mask;    // bit per dead channel, same order as FINGER_*
+    uint32_t blocks;      // blocks judged
+} flex_health_t;
+
+extern const char *const flex_channel_names[FLEX_CHANNELS];
+extern const char *const flex_fault_names[FLEX_FAULTS];
+
+void flex_health_init(flex_health_t *h);
+
+// Judge n_frames raw interleaved frames (in[k * FLEX_CHANNELS + ch]) as one
+// block; returns true when dead_mask changed
+bool flex_health_block(flex_health_t *h, const uint16_t *in, int n_frames);
+
+// "thumb=ok/mean/sd/noise/rail_hits,..." with "dead(fault)" for dead channels; returns length
+int flex_health_format(const flex_health_t *h, char *buf, size_t len);
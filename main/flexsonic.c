@@ -0,0 +1,342 @@
+// Flex + gyro gestures mapped to audio, vocabulary and model loaded from the model partition
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "builtin_vocab.h"
+#include "dfplayer.h"
+#include "flex_adc.h"
+#include "flex_filter.h"
+#include "flex_health.h"
+#include "gesture.h"
+#include "governor.h"
+#include "model_store.h"
+#include "mpu6050.h"
+#include "perf.h"
+#include "recorder.h"
+#include "startup.h"
+
+// ------------------- CONFIG -------------------
+// Startup steps, brought up concurrently
+#define STEP_ADC      0
+#define STEP_IMU      1
+#define STEP_DFPLAYER 2
+#define STARTUP_TIMEOUT_MS 3500
+#define FLAP_MS 1500              // a different track this soon after the last is suspect
+
+static const char *TAG = "FLEXSONIC";
+
+_Static_assert(PERF_STAGE_CENTROID - PERF_STAGE_MASK == GESTURE_STAGE_CENTROID - GESTURE_STAGE_MASK,
+               "one perf kernel per cascade stage");
+
+static const flex_filter_cfg_t filter_cfg = FLEX_FILTER_DEFAULTS;
+
+static flex_filter_t flex_filter;
+static flex_health_t flex_health;
+static governor_t governor;
+static uint8_t model_iir_shift;       // the governor deepens or shortens the low-pass around it
+static uint16_t raw_frames[FLEX_ADC_MAX_FRAMES * FLEX_CHANNELS];
+static uint16_t filtered_frames[FLEX_ADC_MAX_FRAMES * FLEX_CHANNELS];
+
+// ------------------- BUILT-IN VOCABULARY -------------------
+// Used when no valid blob is flashed: the "sentence" cascade of the exporter
+// (4_sentence_gesture.c), generated into builtin_vocab.h.
+static const model_blob_header_t builtin_header = {
+    .n_features = NUM_FLEX,
+    .n_rules = sizeof(builtin_rules) / sizeof(builtin_rules[0]),
+};
+
+static const model_blob_view_t builtin_model = {
+    .header = &builtin_header,
+    .rules = builtin_rules,
+};
+
+// ------------------- FLEX SENSOR FUNCTIONS -------------------
+// Filter what the DMA collected since the last frame (at most max_frames, so
+// the frame time stays bounded); keep the newest output. The health monitor
+// judges the same raw block.
+static void read_flex(int flex[NUM_FLEX], int max_frames) {
+    uint32_t t0 = perf_now();
+    int n = flex_adc_read(raw_frames, max_frames);
+    uint32_t t1 = perf_now();
+    int n_out = flex_filter_block(&flex_filter, raw_frames, n, filtered_frames);
+    uint32_t t2 = perf_now();
+    flex_health_block(&flex_health, raw_frames, n);
+    perf_add(PERF_ADC_READ, t1 - t0);
+    perf_add(PERF_FILTER, t2 - t1);
+    perf_add(PERF_HEALTH, perf_now() - t2);
+    if (n_out == 0) return;
+
+    const uint16_t *latest = &filtered_frames[(n_out - 1) * FLEX_CHANNELS];
+    for (int i = 0; i < NUM_FLEX; i++) flex[i] = latest[i];
+}
+
+// Filter settings recorded in the model blob by ml/sweep_models.py, else the defaults
+static void apply_model_filter(const model_blob_header_t *h) {
+    flex_filter_cfg_t cfg = filter_cfg;
+    if (h->decimation) {
+        cfg.median_n = h->median_n;
+        cfg.iir_shift = h->iir_shift;
+        cfg.decimation = h->decimation;
+    }
+    flex_filter_init(&flex_filter, &cfg);
+    model_iir_shift = cfg.iir_shift;
+    ESP_LOGI(TAG, "Filter: median %d, iir >> %d, decimation %d, hold %d frames",
+             cfg.median_n, cfg.iir_shift, cfg.decimation, h->hold_frames);
+}
+
+// ------------------- SAMPLING GOVERNOR -------------------
+static void governor_setup(void) {
+    governor_cfg_t cfg = GOVERNOR_DEFAULTS;
+#if CONFIG_FLEXSONIC_GOVERNOR
+    cfg.level[GOVERNOR_MOTION].frame_ms = CONFIG_FLEXSONIC_GOV_FAST_MS;
+    cfg.level[GOVERNOR_REST].frame_ms = CONFIG_FLEXSONIC_GOV_SLOW_MS;
+#else
+    // Activity is still tracked for telemetry; every level samples like READY
+    cfg.level[GOVERNOR_REST] = cfg.level[GOVERNOR_MOTION] = cfg.level[GOVERNOR_READY];
+#endif
+    governor_init(&governor, &cfg);
+}
+
+// Low-pass depth and gyro bandwidth of the current level; the frame period,
+// block size and converter duty are applied by the frame loop
+static void governor_apply(void) {
+    const governor_setting_t *gs = governor_setting(&governor);
+    int shift = model_iir_shift + gs->iir_delta;
+    flex_filter_set_iir(&flex_filter, shift < 0 ? 0 : shift > 6 ? 6 : shift);
+    mpu6050_set_dlpf(gs->imu_dlpf);
+}
+
+static void log_governor_change(void) {
+    const governor_setting_t *gs = governor_setting(&governor);
+    ESP_LOGI(TAG, "Governor %s: %d ms frames, %d raw frames, iir >> %d, gyro dlpf %d, adc %s",
+             governor_level_names[governor.level], gs->frame_ms, gs->raw_frames, flex_filter.cfg.iir_shift,
+             gs->imu_dlpf, gs->adc_paused ? "paused between frames" : "continuous");
+}
+
+// GOVERNOR telemetry: level, activity and the time share of each level
+static void governor_dump(void) {
+    char line[160];
+    governor_format(&governor, line, sizeof(line));
+    ESP_LOGI(TAG, "GOVERNOR %s", line);
+}
+
+// Sleep until the next frame. The pool is emptied one block's time before it,
+// so the frame filters the newest conversions; a paused converter is
+// restarted at that point instead.
+static void governor_sleep(void) {
+    const governor_setting_t *gs = governor_setting(&governor);
+    uint32_t fill_ms = gs->raw_frames * 1000 / FLEX_ADC_FRAME_HZ + 1;
+    if (gs->adc_paused) flex_adc_pause();
+    vTaskDelay(pdMS_TO_TICKS(gs->frame_ms - fill_ms));
+    if (gs->adc_paused) {
+        flex_adc_resume();
+    } else {
+        flex_adc_flush();
+    }
+    vTaskDelay(pdMS_TO_TICKS(fill_ms));
+}
+
+// ------------------- SENSOR HEALTH -------------------
+// One line per finger that died or came back since the last frame
+static void log_health_change(uint8_t old_mask, uint8_t new_mask) {
+    for (int ch = 0; ch < FLEX_CHANNELS; ch++) {
+        uint8_t bit = 1u << ch;
+        if (!((old_mask ^ new_mask) & bit)) continue;
+        const flex_health_channel_t *c = &flex_health.ch[ch];
+        if (new_mask & bit) {
+            ESP_LOGW(TAG, "Flex %s dead (%s at %d), recognising without it",
+                     flex_channel_names[ch], flex_fault_names[c->fault], c->dead_at);
+        } else {
+            ESP_LOGI(TAG, "Flex %s back", flex_channel_names[ch]);
+        }
+    }
+}
+
+// HEALTH telemetry: state/mean/sd/noise/rail_hits per finger, then the dead mask
+static void health_dump(void) {
+    char line[288];
+    flex_health_format(&flex_health, line, sizeof(line));
+    ESP_LOGI(TAG, "HEALTH %s,dead=0x%02x", line, flex_health.dead_mask);
+}
+
+// ------------------- FLIGHT RECORDER -------------------
+// Internal anomalies freeze the recorder once per kind per boot: the first
+// occurrence is the interesting one and the flash is not worn by a repeat
+static uint32_t anomalies_seen;
+
+static void anomaly(recorder_trigger_t why) {
+    if (anomalies_seen & (1u << why)) return;
+    if (recorder_trigger(&flight_recorder, why)) anomalies_seen |= 1u << why;
+}
+
+// The frame as classified, its decision and what was played
+static void record_frame(const gesture_frame_t *f, const gesture_result_t *r, int played,
+                         uint32_t t_ms, uint8_t flags) {
+    recorder_frame_t rf = {
+        .t_ms = t_ms,
+        .track = r->track,
+        .candidate = r->candidate,
+        .played = played,
+        .confidence = (uint8_t)(r->confidence * 100),
+        .stage = r->stage,
+        .dead_mask = f->dead_mask,
+        .level = governor.level,
+        .flags = flags | (played ? RECORDER_PLAYED : 0),
+    };
+    for (int i = 0; i < NUM_FLEX; i++) rf.flex[i] = f->flex[i];
+    for (int a = 0; a < 3; a++) rf.gyro[a] = f->gyro[a];
+    recorder_record(&rf);
+}
+
+// ------------------- MAIN APP -------------------
+static const startup_step_t startup_steps[] = {
+    [STEP_ADC]      = { "adc",      flex_adc_init },
+    [STEP_IMU]      = { "imu",      mpu6050_init },
+    [STEP_DFPLAYER] = { "dfplayer", dfplayer_init },
+};
+
+void app_main(void) {
+    gesture_state_t state = { 0 };
+    const model_blob_header_t *filter_from = NULL;
+    int n_frames = 0;
+    int64_t last_frame_us = 0;
+    uint32_t overruns = 0, last_play_ms = 0;
+    int last_track = 0;
+    bool first_frame = true, first_gesture = true;
+    gesture_frame_t frame = { 0 };
+
+    flex_filter_init(&flex_filter, &filter_cfg);
+    model_iir_shift = filter_cfg.iir_shift;
+    flex_health_init(&flex_health);
+    governor_setup();
+    startup_begin(startup_steps, sizeof(startup_steps) / sizeof(startup_steps[0]));
+
+    // Sampling only needs the sensors; the DFPlayer keeps booting its SD card meanwhile
+    if (!startup_wait(STARTUP_STEP(STEP_ADC) | STARTUP_STEP(STEP_IMU), pdMS_TO_TICKS(STARTUP_TIMEOUT_MS))) {
+        ESP_LOGW(TAG, "Sensor bring-up incomplete");
+    }
+    ESP_LOGI(TAG, "System Ready. Monitoring sensors...");
+
+    // Mapped (or copied to DRAM in the release profile) before the frame loop
+    model_store_get();
+    governor_apply();
+    log_governor_change();
+    recorder_start();
+
+    while (1) {
+        // A model selected together with filter settings brings them along;
+        // its log line and I2C write happen before the frame budget starts
+        const model_blob_view_t *model = model_store_get();
+        if (model && model->header != filter_from) {
+            apply_model_filter(model->header);
+            governor_apply();
+            recorder_set_model(model->header->generation);
+            filter_from = model->header;
+        }
+        uint32_t flash_epoch = recorder_flash_epoch();
+        uint32_t frame_start = perf_now();
+
+        // FLEX READINGS
+        uint8_t rec_flags = 0, old_dead = frame.dead_mask;
+        read_flex(frame.flex, governor_setting(&governor)->raw_frames);
+        if (flex_health.dead_mask != frame.dead_mask) {
+            frame.dead_mask = flex_health.dead_mask;
+            rec_flags |= RECORDER_DEAD;
+        }
+
+        // GYRO READINGS
+        uint32_t t0 = perf_now();
+        if (mpu6050_read_gyro(frame.gyro) != ESP_OK) {
+            frame.gyro[0] = frame.gyro[1] = frame.gyro[2] = 0;
+        }
+        perf_add(PERF_IMU_READ, perf_now() - t0);
+
+        // The flashed model, else the built-in vocabulary; the hold counts this level's period
+        state.frame_ms = governor_setting(&governor)->frame_ms;
+        t0 = perf_now();
+        gesture_result_t result;
+        int track = gesture_decide(model ? model : &builtin_model, &frame, &state, &result);
+        uint32_t classify_cycles = perf_now() - t0;
+        perf_add(PERF_CLASSIFY, classify_cycles);
+        perf_add(PERF_STAGE_MASK + result.stage, classify_cycles);
+
+        // Next frame's rate and depth follow this frame's activity
+        int64_t now_us = esp_timer_get_time();
+        uint32_t elapsed_ms = last_frame_us ? (now_us - last_frame_us) / 1000 : 0;
+        last_frame_us = now_us;
+        bool level_changed = governor_update(&governor, &frame, result.track <= GESTURE_REST, elapsed_ms);
+        uint32_t frame_cycles = perf_now() - frame_start;
+        if ((flash_epoch & 1) || recorder_flash_epoch() != flash_epoch) {
+            perf_stalled();   // the dump task had the flash: not this frame's time
+        } else {
+            perf_add(PERF_FRAME, frame_cycles);
+        }
+        if (rec_flags & RECORDER_DEAD) {
+            // Logged outside the frame budget
+            log_health_change(old_dead, frame.dead_mask);
+            if (frame.dead_mask & ~old_dead) anomaly(RECORDER_TRIGGER_SENSOR);
+        }
+        if (level_changed) {
+            // One I2C write, outside the frame budget
+            governor_apply();
+            log_governor_change();
+            rec_flags |= RECORDER_LEVEL;
+        }
+        if (perf_overruns() != overruns) {
+            overruns = perf_overruns();
+            anomaly(RECORDER_TRIGGER_OVERRUN);
+        }
+
+        ESP_LOGI(TAG,
+         "Thumb:%d | Index:%d | Middle:%d | Ring:%d | Pinky:%d || Gyro X:%d Y:%d Z:%d",
+         frame.flex[0], frame.flex[1], frame.flex[2], frame.flex[3], frame.flex[4],
+         frame.gyro[0], frame.gyro[1], frame.gyro[2]);
+
+        if (first_frame) {
+            // Lazy driver and stdio buffers exist now; nothing below may allocate
+            startup_mark("first_frame");
+            perf_arm_alloc_guard();
+            first_frame = false;
+        }
+
+        // Confidence in percent: float formatting would allocate in newlib's dtoa
+        if (result.track == GESTURE_UNKNOWN) {
+            ESP_LOGI(TAG, "Rejected track %d (confidence %d%%)", result.candidate, (int)(result.confidence * 100));
+        }
+        uint32_t now_ms = now_us / 1000;
+        if (track == RECORDER_WRONG_TRACK) {
+            // The wearer says the last play was wrong: keep what led up to it
+            ESP_LOGW(TAG, "Marked wrong, dumping the flight recorder");
+            recorder_trigger(&flight_recorder, RECORDER_TRIGGER_WRONG);
+            track = 0;
+        }
+        if (track) {
+            if (last_track && track != last_track && now_ms - last_play_ms < FLAP_MS) {
+                anomaly(RECORDER_TRIGGER_FLAP);
+            }
+            last_track = track;
+            last_play_ms = now_ms;
+            if (first_gesture) {
+                startup_mark("first_gesture");
+                startup_wait(STARTUP_STEP(STEP_DFPLAYER), pdMS_TO_TICKS(STARTUP_TIMEOUT_MS));
+                startup_dump();
+                first_gesture = false;
+            }
+            ESP_LOGI(TAG, "Track %d (confidence %d%%)", track, (int)(result.confidence * 100));
+            play_mp3_file(track);
+        }
+        record_frame(&frame, &result, track, now_ms, rec_flags);
+
+        if (++n_frames % PERF_DUMP_FRAMES == 0) {
+            perf_dump();
+            health_dump();
+            governor_dump();
+        }
+
+        governor_sleep();
+    }
+}
@@ -0,0 +1,345 @@
+#include <float.h>
+#include <limits.h>
+#include <string.h>
+#include "gesture.h"
+
+static float clamp01(float x) {
+    return x < 0 ? 0 : x > 1 ? 1 : x;
+}
+
+// Square root without libm, which lives in flash: exponent-halving guess plus
+// three Newton steps, well below float precision for distances
+static float root(float x) {
+    uint32_t u;
+    float y;
+
+    if (x <= 0) return 0;
+    memcpy(&u, &x, sizeof(u));
+    u = (u >> 1) + 0x1FC00000u;
+    memcpy(&y, &u, sizeof(y));
+    for (int i = 0; i < 3; i++) y = 0.5f * (y + x / y);
+    return y;
+}
+
+// Signed depth inside the rule's condition, in units of its confidence span:
+// > 0 when the rule fires, < 0 by how far it is from firing. Dead fingers are
+// left out; a rule that fires on the rest may or may not hold, so it scores 0.
+static float rule_score(const model_rule_t *r, const gesture_frame_t *f) {
+    float score = FLT_MAX;
+
+    if (r->flags & MODEL_RULE_GYRO) {
+        float best = -FLT_MAX;
+        const int16_t th[3] = { r->gyro_x, r->gyro_y, r->gyro_z };
+        for (int a = 0; a < 3; a++) {
+            float d = (f->gyro[a] - th[a]) / GYRO_CONF_SPAN;
+            if (d > best) best = d;
+        }
+        return best;
+    }
+    uint8_t live = r->flex_mask & ~f->dead_mask;
+    if (live == 0) return -FLT_MAX;
+    for (int i = 0; i < NUM_FLEX; i++) {
+        if (!(live & (1u << i))) continue;
+        int v = f->flex[i];
+        int inside = v - r->flex_lo < r->flex_hi - v ? v - r->flex_lo : r->flex_hi - v;
+        float d = inside / RULE_CONF_SPAN;
+        if (d < score) score = d;
+    }
+    return live != r->flex_mask && score > 0 ? 0 : score;
+}
+
+void gesture_scale_features(const model_blob_view_t *m, const gesture_frame_t *f, float *x) {
+    for (int j = 0; j < m->header->n_features; j++) {
+        float raw = j < NUM_FLEX ? (float)f->flex[j] : (float)f->gyro[j - NUM_FLEX];
+        x[j] = (raw - m->scaler_mean[j]) / m->scaler_scale[j];
+    }
+}
+
+int gesture_nearest_centroid(const model_blob_view_t *m, const gesture_frame_t *f,
+                             float *d1, float *d2) {
+    const int nf = m->header->n_features;
+    float x[MODEL_MAX_FEATURES];
+    int best = -1;
+    float best_d = FLT_MAX, second_d = FLT_MAX;
+
+    gesture_scale_features(m, f, x);
+    for (int c = 0; c < m->header->n_clusters; c++) {
+        const float *ctr = &m->centroids[c * nf];
+        float d = 0;
+        for (int j = 0; j < nf; j++) {
+            if (j < NUM_FLEX && (f->dead_mask & (1u << j))) continue;
+            float diff = x[j] - ctr[j];
+            d += diff * diff;
+        }
+        if (d < best_d) {
+            second_d = best_d;
+            best_d = d;
+            best = c;
+        } else if (d < second_d) {
+            second_d = d;
+        }
+    }
+    if (d1) *d1 = root(best_d);
+    if (d2) *d2 = second_d < FLT_MAX ? root(second_d) : FLT_MAX;
+    return best;
+}
+
+uint8_t gesture_cluster_fingers(const model_blob_view_t *m, int c) {
+    const int nf = m->header->n_features;
+    float d[NUM_FLEX], top = 0;
+    uint8_t mask = 0;
+
+    for (int j = 0; j < NUM_FLEX && j < nf; j++) {
+        float open = (0 - m->scaler_mean[j]) / m->scaler_scale[j];
+        d[j] = m->centroids[c * nf + j] - open;
+        d[j] *= d[j];
+        if (d[j] > top) top = d[j];
+    }
+    for (int j = 0; j < NUM_FLEX && j < nf; j++) {
+        if (top > 0 && d[j] * 4 >= top) mask |= 1u << j;
+    }
+    return mask;
+}
+
+// Same cleaning as training: a hand with no flex reading is at rest
+static bool hand_at_rest(const gesture_frame_t *f) {
+    int flex_sum = 0;
+    for (int i = 0; i < NUM_FLEX; i++) {
+        if (!(f->dead_mask & (1u << i))) flex_sum += f->flex[i];
+    }
+    return flex_sum <= 0;
+}
+
+// The cascade decision flips when the winner stops firing or an earlier rule
+// starts to; confidence is the product of both margins. Later rules never win.
+static void accept_rule(const model_rule_t *w, float s, float rival, gesture_result_t *r) {
+    r->candidate = w->track;
+    r->flags = w->flags;
+    r->confidence = clamp01(s) * clamp01(-rival);
+    r->track = r->confidence * 1000 >= w->min_conf ? w->track : GESTURE_UNKNOWN;
+}
+
+static void classify_rules(const model_blob_view_t *m, const gesture_frame_t *f, gesture_result_t *r) {
+    float rival = -FLT_MAX;
+
+    for (int i = 0; i < m->header->n_rules; i++) {
+        const model_rule_t *w = &m->rules[i];
+        float s = rule_score(w, f);
+        if (s < 0) {
+            if (s > rival) rival = s;
+            continue;
+        }
+        accept_rule(w, s, rival, r);
+        return;
+    }
+}
+
+// Flex range shared by every flex rule, if there is one
+static bool shared_range(const model_blob_view_t *m, int16_t *lo, int16_t *hi) {
+    bool first = true;
+    *lo = *hi = 0;
+    for (int i = 0; i < m->header->n_rules; i++) {
+        const model_rule_t *w = &m->rules[i];
+        if ((w->flags & MODEL_RULE_GYRO) || w->flex_mask == 0) continue;
+        if (first) {
+            *lo = w->flex_lo;
+            *hi = w->flex_hi;
+            first = false;
+        } else if (w->flex_lo != *lo || w->flex_hi != *hi) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Depth of the shallowest live finger of a rule in confidence spans, 0 at most with a dead one
+static float mask_depth(const int depth[NUM_FLEX], uint8_t mask, uint8_t dead) {
+    int d = INT_MAX;
+    uint8_t live = mask & ~dead;
+    if (live == 0) return -FLT_MAX;
+    for (int i = 0; i < NUM_FLEX; i++) {
+        if ((live & (1u << i)) && depth[i] < d) d = depth[i];
+    }
+    return live != mask && d > 0 ? 0 : d / RULE_CONF_SPAN;
+}
+
+// Same decision and confidence as classify_rules when all flex rules share
+// one range: one depth per finger, a flex rule fires iff its mask is all bent,
+// and the rivals are only scored once a winner exists
+static void classify_mask(const model_blob_view_t *m, const gesture_frame_t *f, int16_t lo, int16_t hi,
+                          gesture_result_t *r) {
+    int depth[NUM_FLEX];
+    uint8_t bent = 0;
+    int i;
+    float s = 0;
+
+    for (int k = 0; k < NUM_FLEX; k++) {
+        int v = f->flex[k];
+        depth[k] = v - lo < hi - v ? v - lo : hi - v;
+        if (depth[k] >= 0) bent |= 1u << k;
+    }
+    bent |= f->dead_mask;   // as far as the live fingers tell
+    for (i = 0; i < m->header->n_rules; i++) {
+        const model_rule_t *w = &m->rules[i];
+        if (w->flags & MODEL_RULE_GYRO) {
+            if ((s = rule_score(w, f)) >= 0) break;
+        } else if ((w->flex_mask & ~f->dead_mask) && !(w->flex_mask & ~bent)) {
+            s = mask_depth(depth, w->flex_mask, f->dead_mask);
+            break;
+        }
+    }
+    if (i == m->header->n_rules) return;   // open hand, no rule fires
+
+    float rival = -FLT_MAX;
+    for (int j = 0; j < i; j++) {
+        const model_rule_t *w = &m->rules[j];
+        float d = (w->flags & MODEL_RULE_GYRO) ? rule_score(w, f)
+                : w->flex_mask ? mask_depth(depth, w->flex_mask, f->dead_mask) : -FLT_MAX;
+        if (d > rival) rival = d;
+    }
+    accept_rule(&m->rules[i], s, rival, r);
+}
+
+static void classify_centroids(const model_blob_view_t *m, const gesture_frame_t *f, gesture_result_t *r) {
+    float d1, d2;
+    int c = gesture_nearest_centroid(m, f, &d1, &d2);
+    if (c < 0) return;
+
+    float conf = d2 < FLT_MAX ? (d2 - d1) / (d2 + d1 + 1e-6f) : 1.0f;
+    if (m->cluster_radius[c] > 0 && d1 > m->cluster_radius[c]) conf = 0;
+    if (f->dead_mask && (gesture_cluster_fingers(m, c) & f->dead_mask)) conf = 0;
+
+    r->candidate = m->cluster_track[c];
+    r->flags = 0;
+    r->confidence = clamp01(conf);
+    if (r->candidate == GESTURE_REST) {
+        r->track = GESTURE_REST;   // a cluster of resting hands
+        return;
+    }
+    r->track = r->confidence * 1000 >= m->cluster_min_conf[c] ? r->candidate : GESTURE_UNKNOWN;
+}
+
+static bool hand_still(const gesture_frame_t *f, const gesture_frame_t *ref) {
+    if (f->dead_mask != ref->dead_mask) return false;
+    for (int i = 0; i < NUM_FLEX; i++) {
+        if (f->dead_mask & (1u << i)) continue;
+        int d = f->flex[i] - ref->flex[i];
+        if (d > GESTURE_STILL_FLEX || d < -GESTURE_STILL_FLEX) return false;
+    }
+    for (int a = 0; a < 3; a++) {
+        int d = f->gyro[a] - ref->gyro[a];
+        if (d > GESTURE_STILL_GYRO || d < -GESTURE_STILL_GYRO) return false;
+    }
+    return true;
+}
+
+// The cascade; st = NULL skips the steady stage
+static void classify(const model_blob_view_t *m, const gesture_frame_t *f, gesture_state_t *st,
+                     gesture_result_t *r) {
+    int16_t lo, hi;
+    bool shared;
+
+    r->track = GESTURE_REST;
+    r->candidate = GESTURE_REST;
+    r->confidence = 1.0f;
+    r->flags = 0;
+    r->stage = GESTURE_STAGE_MASK;
+
+    if (st && st->model != m->header) {
+        st->model = m->header;
+        st->shared_range = shared_range(m, &st->bend_lo, &st->bend_hi);
+        st->still_valid = false;
+    }
+    if (st) {
+        shared = st->shared_range;
+        lo = st->bend_lo;
+        hi = st->bend_hi;
+    } else {
+        shared = shared_range(m, &lo, &hi);
+    }
+    if (shared) {
+        classify_mask(m, f, lo, hi, r);
+    } else {
+        r->stage = GESTURE_STAGE_RULES;
+        classify_rules(m, f, r);
+    }
+
+    // Escalate when no rule fired or the one that did is unsure; gyro rules
+    // still fire on an open hand, but the clusters never see one
+    bool unsure = r->track == GESTURE_UNKNOWN;
+    if ((r->candidate != GESTURE_REST && !unsure) || m->header->n_clusters == 0 || hand_at_rest(f)) return;
+
+    gesture_result_t c = *r;
+    if (st && st->still_valid && hand_still(f, &st->still_frame)) {
+        c = st->still_result;
+        c.stage = GESTURE_STAGE_STEADY;
+    } else {
+        classify_centroids(m, f, &c);
+        c.stage = GESTURE_STAGE_CENTROID;
+        if (st) {
+            st->still_frame = *f;
+            st->still_result = c;
+            st->still_valid = true;
+        }
+    }
+    if (unsure && c.track <= 0) {
+        r->stage = c.stage;   // the rule's unknown stands
+        return;
+    }
+    *r = c;
+}
+
+void gesture_classify(const model_blob_view_t *m, const gesture_frame_t *f, gesture_result_t *r) {
+    classify(m, f, NULL, r);
+}
+
+// Whether a resting hand re-arms the last play. A MODEL_RULE_REARM gyro rule
+// holds its track until the wrist is well clear of every threshold, so gyro
+// jitter around the threshold cannot replay it (4_sentence_gesture.c: fires
+// above 1000, re-arms below 600).
+static bool rearmed(const model_blob_view_t *m, const gesture_frame_t *f, int last_played) {
+    for (int i = 0; i < m->header->n_rules; i++) {
+        const model_rule_t *w = &m->rules[i];
+        if (w->track != last_played || (w->flags & (MODEL_RULE_GYRO | MODEL_RULE_REARM))
+                                       != (MODEL_RULE_GYRO | MODEL_RULE_REARM)) {
+            continue;
+        }
+        if (f->gyro[0] > w->gyro_x - w->flex_lo || f->gyro[1] > w->gyro_y - w->flex_lo
+            || f->gyro[2] > w->gyro_z - w->flex_lo) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int gesture_decide(const model_blob_view_t *m, const gesture_frame_t *f, gesture_state_t *st,
+                   gesture_result_t *r) {
+    gesture_result_t res;
+    if (!r) r = &res;
+
+    classify(m, f, st, r);
+    if (r->track == GESTURE_UNKNOWN) {
+        st->streak_ms = 0;
+        return 0;
+    }
+    if (r->track == GESTURE_REST) {
+        if (rearmed(m, f, st->last_played)) st->last_played = 0; // Reset trigger when nothing is in range
+        st->streak_ms = 0;
+        return 0;
+    }
+
+    // 0 and 1 both played on the first frame of the fixed period
+    uint32_t hold_ms = (m->header->hold_frames ? m->header->hold_frames : 1) * GESTURE_HOLD_FRAME_MS;
+    uint32_t frame_ms = st->frame_ms ? st->frame_ms : GESTURE_HOLD_FRAME_MS;
+    if (r->track == st->streak_track && st->streak_ms > 0) {
+        if (st->streak_ms < hold_ms) st->streak_ms += frame_ms;
+    } else {
+        st->streak_track = r->track;
+        st->streak_ms = frame_ms;
+    }
+    if (st->streak_ms < hold_ms) return 0;
+
+    if (r->track == st->last_played && !(r->flags & MODEL_RULE_REPEAT)) return 0;
+    st->last_played = r->track;
+    return r->track;
+}
@@ -0,0 +1,96 @@
+// Gesture recognition on one sensor frame, driven entirely by a model_blob_view_t
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "model_blob.h"
+
+#define NUM_FLEX 5
+
+#define GESTURE_REST     0
+#define GESTURE_UNKNOWN -1   // a gesture was seen but scored below its threshold
+
+// Distances that map to full confidence: flex counts for rule ranges, raw gyro units
+#define RULE_CONF_SPAN 500.0f
+#define GYRO_CONF_SPAN 2000.0f
+
+typedef struct {
+    int flex[NUM_FLEX];   // Thumb, Index, Middle, Ring, Pinky
+    int16_t gyro[3];      // X, Y, Z
+    uint8_t dead_mask;    // FINGER_* bits of sensors the health monitor failed
+} gesture_frame_t;
+
+// Recognition cascade, cheapest first; a frame stops at the first stage that settles it
+typedef enum {
+    GESTURE_STAGE_MASK,       // integer bend mask: resting hands and the rule cascade
+    GESTURE_STAGE_RULES,      // float rule scores, for rules with different flex ranges
+    GESTURE_STAGE_STEADY,     // hand still since the last centroid frame: reuse its answer
+    GESTURE_STAGE_CENTROID,   // nearest centroid
+    GESTURE_STAGES,
+} gesture_stage_t;
+
+// A hand that moved less than this since the last centroid frame keeps its answer
+#define GESTURE_STILL_FLEX 40     // filtered ADC counts, per finger
+#define GESTURE_STILL_GYRO 400    // raw gyro units, per axis
+
+// hold_frames counts frames of the fixed loop period models are scored at;
+// the hold is this much time per frame whatever period the loop runs at
+#define GESTURE_HOLD_FRAME_MS 300
+
+typedef struct {
+    int track;            // track to play, GESTURE_REST or GESTURE_UNKNOWN
+    int candidate;        // best track before the acceptance threshold was applied
+    float confidence;     // 0..1
+    uint8_t flags;        // MODEL_RULE_* of the winning rule
+    uint8_t stage;        // gesture_stage_t that settled the frame
+} gesture_result_t;
+
+// Decision state carried from frame to frame
+typedef struct {
+    int last_played;      // track of the last play, 0 once the hand rests
+    int streak_track;     // track the recent frames agree on
+    uint32_t streak_ms;   // consecutive frames of streak_track, their periods summed
+    uint16_t frame_ms;    // period of the frames being decided, 0 = GESTURE_HOLD_FRAME_MS
+
+    // Cascade caches, rebuilt when the model header changes
+    const model_blob_header_t *model;
+    bool shared_range;    // every flex rule uses [bend_lo, bend_hi]: the mask stage applies
+    int16_t bend_lo, bend_hi;
+    bool still_valid;
+    gesture_frame_t still_frame;   // last frame the centroids classified
+    gesture_result_t still_result;
+} gesture_state_t;
+
+// Standardise the frame with the model's scaler into x[n_features]
+void gesture_scale_features(const model_blob_view_t *m, const gesture_frame_t *f, float *x);
+
+// Nearest and second-nearest K-Means centroid (scaled space, dead fingers left
+// out); returns nearest, -1 if none
+int gesture_nearest_centroid(const model_blob_view_t *m, const gesture_frame_t *f,
+                             float *d1, float *d2);
+
+// Fingers a cluster's gesture bends: those holding at least a quarter of the
+// largest per-finger distance between its centroid and an open hand
+uint8_t gesture_cluster_fingers(const model_blob_view_t *m, int c);
+
+// Classify one frame. Rules: first firing rule wins, scored by how deep the
+// fingers sit inside its range and how far every earlier rule is from firing.
+// Centroids: margin (d2 - d1) / (d2 + d1), zero outside the cluster radius.
+// Centroids run only when no rule fires or the firing rule is below its
+// threshold; a confident centroid then replaces the unknown.
+// Degraded mode: fingers in f->dead_mask are ignored. A rule is judged on its
+// live fingers and fires with zero confidence if it needs a dead one; centroids
+// are compared on the live features, and a cluster that bends a dead finger
+// wins with zero confidence. A gesture the dead finger would have told apart
+// is rejected instead of played wrong.
+void gesture_classify(const model_blob_view_t *m, const gesture_frame_t *f, gesture_result_t *r);
+
+// Track to play for this frame (0 = nothing new). A track plays once it has
+// been recognised for hold_frames * GESTURE_HOLD_FRAME_MS in a row, counted in
+// st->frame_ms periods; a caller that changes its period sets it first. Unknown frames break
+// the streak but keep the repeat suppression; resting frames lift it, after a
+// MODEL_RULE_REARM gyro rule only once the wrist is back below its re-arm level. Classifies like gesture_classify
+// plus the steady stage. r is optional.
+int gesture_decide(const model_blob_view_t *m, const gesture_frame_t *f, gesture_state_t *st,
+                   gesture_result_t *r);
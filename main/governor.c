@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "governor.h"
+
+const char *const governor_level_names[GOVERNOR_LEVELS] = {
+    [GOVERNOR_REST] = "rest", [GOVERNOR_READY] = "ready", [GOVERNOR_MOTION] = "motion",
+};
+
+#define BIAS_SHIFT 5   // gyro bias follows a still hand over ~32 frames
+
+void governor_init(governor_t *g, const governor_cfg_t *cfg) {
+    memset(g, 0, sizeof(*g));
+    g->cfg = *cfg;
+    g->level = GOVERNOR_READY;
+}
+
+// Fastest live finger, in counts per second so the thresholds hold at any frame period
+static uint32_t flex_rate(governor_t *g, const gesture_frame_t *f, uint32_t elapsed_ms) {
+    uint32_t fastest = 0;
+
+    for (int i = 0; i < NUM_FLEX; i++) {
+        if (f->dead_mask & (1u << i)) continue;
+        uint32_t rate = (uint32_t)abs(f->flex[i] - g->prev_flex[i]) * 1000 / elapsed_ms;
+        if (rate > fastest) fastest = rate;
+    }
+    return fastest;
+}
+
+// Gyro is already a rate: how far it sits from its zero-rate bias
+static uint32_t gyro_energy(const governor_t *g, const gesture_frame_t *f) {
+    uint32_t sum = 0;
+
+    for (int a = 0; a < 3; a++) {
+        sum += (uint32_t)abs(f->gyro[a] - (g->gyro_bias[a] >> 4));
+    }
+    return sum;
+}
+
+bool governor_update(governor_t *g, const gesture_frame_t *f, bool idle, uint32_t elapsed_ms) {
+    const governor_cfg_t *c = &g->cfg;
+    uint8_t old = g->level;
+
+    if (elapsed_ms == 0) elapsed_ms = 1;
+    if (!g->primed) {
+        for (int a = 0; a < 3; a++) g->gyro_bias[a] = f->gyro[a] * 16;
+        g->primed = true;
+    } else {
+        // Rise at once, decay over a couple of frames: one sharp bend is enough to speed up
+        uint32_t rate = flex_rate(g, f, elapsed_ms), energy = gyro_energy(g, f);
+        g->flex_rate = rate > g->flex_rate ? rate : (g->flex_rate + rate) / 2;
+        g->gyro_energy = energy > g->gyro_energy ? energy : (g->gyro_energy + energy) / 2;
+    }
+    memcpy(g->prev_flex, f->flex, sizeof(g->prev_flex));
+    g->level_ms[g->level] += elapsed_ms;
+
+    bool moving = g->flex_rate >= c->motion_flex || g->gyro_energy >= c->motion_gyro;
+    bool quiet = g->flex_rate < c->quiet_flex && g->gyro_energy < c->quiet_gyro;
+    if (quiet) {
+        for (int a = 0; a < 3; a++) g->gyro_bias[a] += (f->gyro[a] * 16 - g->gyro_bias[a]) >> BIAS_SHIFT;
+    }
+    g->since_motion_ms = moving ? 0 : g->since_motion_ms + elapsed_ms;
+    g->quiet_ms = quiet && idle ? g->quiet_ms + elapsed_ms : 0;
+
+    if (moving) {
+        g->level = GOVERNOR_MOTION;
+    } else if (g->level == GOVERNOR_MOTION) {
+        if (g->since_motion_ms >= c->hold_ms) g->level = GOVERNOR_READY;
+    } else if (g->quiet_ms >= c->rest_ms) {
+        g->level = GOVERNOR_REST;
+    } else if (g->quiet_ms == 0) {
+        g->level = GOVERNOR_READY;
+    }
+
+    if (g->level == old) return false;
+    g->switches++;
+    return true;
+}
+
+int governor_format(const governor_t *g, char *buf, size_t len) {
+    uint32_t total = 0;
+    int pos;
+
+    for (int l = 0; l < GOVERNOR_LEVELS; l++) total += g->level_ms[l];
+    if (!total) total = 1;
+    pos = snprintf(buf, len, "level=%s,flex_rate=%lu,gyro=%lu", governor_level_names[g->level],
+                   (unsigned long)g->flex_rate, (unsigned long)g->gyro_energy);
+    for (int l = 0; l < GOVERNOR_LEVELS && pos < (int)len; l++) {
+        pos += snprintf(buf + pos, len - pos, ",%s=%lu%%", governor_level_names[l],
+                        (unsigned long)((uint64_t)g->level_ms[l] * 100 / total));
+    }
+    if (pos < (int)len) pos += snprintf(buf + pos, len - pos, ",switches=%lu", (unsigned long)g->switches);
+    return pos < (int)len ? pos : (int)len - 1;
+}
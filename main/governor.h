@@ -0,0 +1,79 @@
+// Sampling governor: tracks hand activity from the recognition frames and picks
+// how often and how deeply the sensors are sampled. Fast, shallow frames while
+// the hand signs; a slow trickle with heavy averaging while it rests. IDF-free
+// for the host build.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gesture.h"
+
+typedef enum {
+    GOVERNOR_REST,        // still, no gesture held
+    GOVERNOR_READY,       // held gesture or small movements
+    GOVERNOR_MOTION,      // fingers or wrist moving
+    GOVERNOR_LEVELS,
+} governor_level_t;
+
+// What the frame loop does at one level
+typedef struct {
+    uint16_t frame_ms;    // loop period: recognition frames and gyro reads per second
+    uint8_t raw_frames;   // newest ADC frames filtered into one recognition frame
+    int8_t iir_delta;     // added to the model's iir_shift: averaging depth
+    uint8_t imu_dlpf;     // MPU6050 DLPF_CFG: 1 = 188 Hz .. 6 = 5 Hz bandwidth
+    bool adc_paused;      // converter stopped between frames, restarted to fill one block
+} governor_setting_t;
+
+typedef struct {
+    governor_setting_t level[GOVERNOR_LEVELS];
+    uint16_t motion_flex; // flex rate (counts/s) of a moving finger
+    uint16_t motion_gyro; // gyro deviation from its bias (raw units, summed axes) of a moving wrist
+    uint16_t quiet_flex;  // below both: the hand is still
+    uint16_t quiet_gyro;
+    uint16_t hold_ms;     // motion level kept this long after the last movement
+    uint16_t rest_ms;     // still with no gesture for this long drops to rest
+} governor_cfg_t;
+
+// 300 ms frames at READY are the fixed period the firmware ran before
+#define GOVERNOR_DEFAULTS { \
+    .level = { \
+        [GOVERNOR_REST]   = { .frame_ms = 600, .raw_frames = 128, .iir_delta = 1,  .imu_dlpf = 6, .adc_paused = true }, \
+        [GOVERNOR_READY]  = { .frame_ms = 300, .raw_frames = 128, .iir_delta = 0,  .imu_dlpf = 3 }, \
+        [GOVERNOR_MOTION] = { .frame_ms = 100, .raw_frames = 32,  .iir_delta = -1, .imu_dlpf = 1 }, \
+    }, \
+    .motion_flex = 1500, .motion_gyro = 1200, .quiet_flex = 600, .quiet_gyro = 400, \
+    .hold_ms = 1000, .rest_ms = 3000, \
+}
+
+typedef struct {
+    governor_cfg_t cfg;
+    int prev_flex[NUM_FLEX];
+    int32_t gyro_bias[3];     // Q4, follows the gyro while the hand is still
+    uint32_t flex_rate;       // fastest live finger, counts/s, smoothed
+    uint32_t gyro_energy;     // summed |gyro - bias|, smoothed
+    uint32_t since_motion_ms;
+    uint32_t quiet_ms;        // still with no gesture
+    uint8_t level;            // governor_level_t
+    bool primed;
+    uint32_t level_ms[GOVERNOR_LEVELS];   // time spent at each level
+    uint32_t switches;
+} governor_t;
+
+extern const char *const governor_level_names[GOVERNOR_LEVELS];
+
+// Starts at READY
+void governor_init(governor_t *g, const governor_cfg_t *cfg);
+
+// Feed the frame just classified, elapsed_ms after the previous one; dead
+// fingers are ignored. idle: no gesture recognised (rest or rejected), only
+// then can the hand drop to rest. Returns true when the level changed.
+bool governor_update(governor_t *g, const gesture_frame_t *f, bool idle, uint32_t elapsed_ms);
+
+static inline const governor_setting_t *governor_setting(const governor_t *g) {
+    return &g->cfg.level[g->level];
+}
+
+// "level=motion,flex_rate=N,gyro=N,rest=N%,ready=N%,motion=N%,switches=N"; returns length
+int governor_format(const governor_t *g, char *buf, size_t len);
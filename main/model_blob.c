@@ -0,0 +1,62 @@
+#include <string.h>
+#include "model_blob.h"
+
+_Static_assert(sizeof(model_blob_header_t) == 32, "blob header layout");
+_Static_assert(sizeof(model_rule_t) == 16, "blob rule layout");
+_Static_assert(MODEL_BLOB_MAX_SIZE % 4 == 0, "blob max size alignment");
+
+#define ALIGN4(x) (((x) + 3u) & ~3u)
+
+// CRC-32 (IEEE, reflected), same result as Python's zlib.crc32
+uint32_t model_blob_crc32(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+        }
+    }
+    return ~crc;
+}
+
+size_t model_blob_size(uint8_t n_features, uint8_t n_clusters, uint8_t n_rules) {
+    size_t size = sizeof(model_blob_header_t);
+    size += 2u * n_features * sizeof(float);
+    size += (size_t)n_clusters * (n_features + 1) * sizeof(float);
+    size += ALIGN4((size_t)n_clusters * 2 * sizeof(uint16_t));
+    size += (size_t)n_rules * sizeof(model_rule_t);
+    return size;
+}
+
+bool model_blob_parse(const void *blob, size_t len, model_blob_view_t *view) {
+    const model_blob_header_t *h = (const model_blob_header_t *)blob;
+
+    if (blob == NULL || ((uintptr_t)blob & 3u) || len < sizeof(*h)) return false;
+    if (h->magic != MODEL_BLOB_MAGIC || h->version != MODEL_BLOB_VERSION) return false;
+    if (h->header_size != sizeof(*h)) return false;
+    if (model_blob_crc32(0, h, offsetof(model_blob_header_t, header_crc32)) != h->header_crc32) return false;
+    if (h->n_features == 0 || h->n_features > MODEL_MAX_FEATURES) return false;
+    if (h->n_clusters > MODEL_MAX_CLUSTERS || h->n_rules > MODEL_MAX_RULES) return false;
+
+    size_t size = model_blob_size(h->n_features, h->n_clusters, h->n_rules);
+    if (size > len || h->payload_size != size - sizeof(*h)) return false;
+
+    const uint8_t *p = (const uint8_t *)blob + sizeof(*h);
+    if (model_blob_crc32(0, p, h->payload_size) != h->payload_crc32) return false;
+
+    view->header = h;
+    view->scaler_mean = (const float *)p;
+    p += h->n_features * sizeof(float);
+    view->scaler_scale = (const float *)p;
+    p += h->n_features * sizeof(float);
+    view->centroids = (const float *)p;
+    p += (size_t)h->n_clusters * h->n_features * sizeof(float);
+    view->cluster_radius = (const float *)p;
+    p += h->n_clusters * sizeof(float);
+    view->cluster_track = (const uint16_t *)p;
+    view->cluster_min_conf = view->cluster_track + h->n_clusters;
+    p += ALIGN4((size_t)h->n_clusters * 2 * sizeof(uint16_t));
+    view->rules = (const model_rule_t *)p;
+    return true;
+}
@@ -0,0 +1,94 @@
+// Versioned model + vocabulary blob shared by the firmware and ml/5_export_model_blob.py
+//
+// Layout (little-endian, every section 4-byte aligned, read in place from flash):
+//   model_blob_header_t
+//   float    scaler_mean[n_features]
+//   float    scaler_scale[n_features]
+//   float    centroids[n_clusters][n_features]
+//   float    cluster_radius[n_clusters]         (scaled units, 0 = unbounded)
+//   uint16_t cluster_track[n_clusters]
+//   uint16_t cluster_min_conf[n_clusters]       (padded to 4 bytes)
+//   model_rule_t rules[n_rules]
+//
+// Confidence thresholds are in permille; a gesture scoring below its
+// threshold is reported as unknown and never played. 0 accepts everything.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MODEL_BLOB_MAGIC   0x4C444D46u  // "FMDL"
+#define MODEL_BLOB_VERSION 3
+
+#define MODEL_MAX_FEATURES 8   // Thumb..Pinky + GyroX..GyroZ
+#define MODEL_MAX_CLUSTERS 32
+#define MODEL_MAX_RULES    32
+
+// Largest blob these limits allow
+#define MODEL_BLOB_MAX_SIZE (32 + 2 * MODEL_MAX_FEATURES * 4 + MODEL_MAX_CLUSTERS * (MODEL_MAX_FEATURES + 1) * 4 \
+                             + MODEL_MAX_CLUSTERS * 2 * 2 + MODEL_MAX_RULES * 16)
+
+// Finger bits used by model_rule_t.flex_mask
+#define FINGER_THUMB  (1u << 0)
+#define FINGER_INDEX  (1u << 1)
+#define FINGER_MIDDLE (1u << 2)
+#define FINGER_RING   (1u << 3)
+#define FINGER_PINKY  (1u << 4)
+
+// model_rule_t.flags
+#define MODEL_RULE_GYRO   0x01  // fire on gyro_x/y/z thresholds instead of flex ranges
+#define MODEL_RULE_REPEAT 0x02  // allow re-triggering the same track back to back
+#define MODEL_RULE_REARM  0x04  // gyro rule: stays latched until every axis is flex_lo below its threshold
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t generation;     // A/B slot with the higher valid generation wins
+    uint32_t payload_size;   // bytes following the header
+    uint32_t payload_crc32;
+    uint8_t  n_features;
+    uint8_t  n_clusters;
+    uint8_t  n_rules;
+    uint8_t  hold_frames;    // 300 ms frames a gesture must persist before it plays; 0 = 1
+    uint8_t  median_n;       // flex filter bank the model was selected with, 0 = firmware default
+    uint8_t  iir_shift;
+    uint8_t  decimation;
+    uint8_t  reserved;
+    uint32_t header_crc32;   // over every field above
+} model_blob_header_t;
+
+// One entry of the trigger cascade, evaluated in order, first match wins
+typedef struct {
+    uint16_t track;          // NNNN of NNNN.mp3
+    uint8_t  flex_mask;      // fingers that must all be in [flex_lo, flex_hi]
+    uint8_t  flags;
+    int16_t  flex_lo;        // MODEL_RULE_REARM gyro rules: re-arm margin below the thresholds
+    int16_t  flex_hi;
+    int16_t  gyro_x;         // MODEL_RULE_GYRO: fires when any axis exceeds its threshold
+    int16_t  gyro_y;
+    int16_t  gyro_z;
+    uint16_t min_conf;       // acceptance threshold, permille
+} model_rule_t;
+
+// Pointers into the mapped blob, no copies
+typedef struct {
+    const model_blob_header_t *header;
+    const float *scaler_mean;
+    const float *scaler_scale;
+    const float *centroids;
+    const float *cluster_radius;
+    const uint16_t *cluster_track;
+    const uint16_t *cluster_min_conf;
+    const model_rule_t *rules;
+} model_blob_view_t;
+
+uint32_t model_blob_crc32(uint32_t crc, const void *data, size_t len);
+
+// Check magic, version, CRCs and section sizes; fill view on success
+bool model_blob_parse(const void *blob, size_t len, model_blob_view_t *view);
+
+// Total size a blob with these counts occupies
+size_t model_blob_size(uint8_t n_features, uint8_t n_clusters, uint8_t n_rules);
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "spi_flash_mmap.h"
+#include "sdkconfig.h"
+#include "model_store.h"
+
+static const char *TAG = "MODEL_STORE";
+
+typedef struct {
+    const char *label;
+    const esp_partition_t *part;
+    esp_partition_mmap_handle_t handle;
+    bool mapped;
+    bool valid;
+    model_blob_view_t view;
+#if CONFIG_FLEXSONIC_HOT_PATH_IRAM
+    uint32_t ram[MODEL_BLOB_MAX_SIZE / 4];   // DRAM copy the hot path reads instead of the mapping
+#endif
+} model_slot_t;
+
+static model_slot_t slots[2] = { { .label = "model_a" }, { .label = "model_b" } };
+static volatile int active = -1;
+static bool loaded;
+
+static void slot_unmap(model_slot_t *s) {
+    if (s->mapped) esp_partition_munmap(s->handle);
+    s->mapped = false;
+    s->valid = false;
+}
+
+// Map a slot and validate its blob in place
+static void slot_load(model_slot_t *s) {
+    const void *ptr;
+
+    slot_unmap(s);
+    if (s->part == NULL) return;
+    if (esp_partition_mmap(s->part, 0, s->part->size, ESP_PARTITION_MMAP_DATA,
+                           &ptr, &s->handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Could not map %s", s->label);
+        return;
+    }
+    s->mapped = true;
+    s->valid = model_blob_parse(ptr, s->part->size, &s->view);
+    if (!s->valid) {
+        slot_unmap(s);
+        return;
+    }
+
+#if CONFIG_FLEXSONIC_HOT_PATH_IRAM
+    // Parse already bounded the size by the MODEL_MAX_* limits
+    size_t size = sizeof(model_blob_header_t) + s->view.header->payload_size;
+    memcpy(s->ram, ptr, size);
+    esp_partition_munmap(s->handle);
+    s->mapped = false;
+    s->valid = model_blob_parse(s->ram, size, &s->view);
+#endif
+}
+
+esp_err_t model_store_init(void) {
+    loaded = true;
+    for (int i = 0; i < 2; i++) {
+        slots[i].part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                 MODEL_PARTITION_SUBTYPE, slots[i].label);
+        slot_load(&slots[i]);
+    }
+
+    int best = -1;
+    for (int i = 0; i < 2; i++) {
+        if (!slots[i].valid) continue;
+        if (best < 0 || slots[i].view.header->generation > slots[best].view.header->generation) best = i;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (i != best) slot_unmap(&slots[i]);
+    }
+    active = best;
+
+    if (best < 0) {
+        ESP_LOGW(TAG, "No valid model blob, using built-in vocabulary");
+        return ESP_ERR_NOT_FOUND;
+    }
+    const model_blob_header_t *h = slots[best].view.header;
+    ESP_LOGI(TAG, "Model %s gen %lu: %u features, %u clusters, %u rules",
+             slots[best].label, (unsigned long)h->generation, h->n_features, h->n_clusters, h->n_rules);
+    return ESP_OK;
+}
+
+const model_blob_view_t *model_store_get(void) {
+    if (!loaded) model_store_init();
+    int a = active;
+    return a < 0 ? NULL : &slots[a].view;
+}
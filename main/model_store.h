@@ -0,0 +1,17 @@
+// A/B model partitions ("model_a"/"model_b"), mapped in place with esp_partition_mmap
+
+#pragma once
+
+#include "esp_err.h"
+#include "model_blob.h"
+
+#define MODEL_PARTITION_SUBTYPE 0x40
+
+// Map both slots, keep the valid one with the highest generation (model_a on a tie).
+// Slots are written offline by ml/5_export_model_blob.py, which picks the
+// inactive one and the next generation.
+esp_err_t model_store_init(void);
+
+// Active model, NULL when neither slot holds a valid blob.
+// Maps the partitions on first use if model_store_init() was not called.
+const model_blob_view_t *model_store_get(void);
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "mpu6050.h"
+
+// MPU6050
+#define MPU6050_ADDR 0x68
+#define CONFIG       0x1A
+#define PWR_MGMT_1   0x6B
+#define GYRO_XOUT_H  0x43
+#define WHO_AM_I     0x75
+#define WHO_AM_I_VALUE 0x68        // fixed, whatever AD0 sets the bus address to
+#define I2C_MASTER_SCL_IO 22
+#define I2C_MASTER_SDA_IO 21
+#define I2C_MASTER_FREQ_HZ 100000
+#define I2C_PORT I2C_NUM_0
+
+#define MPU6050_READY_TIMEOUT_MS 200
+#define I2C_TIMEOUT_MS 20          // bounds a frame's gyro read when the bus hangs
+
+// Command links are built in static buffers, the per-frame read never touches the heap.
+// Init finishes (or times out) before the frame loop starts reading, so one buffer is enough.
+#define I2C_LINK_BYTES I2C_LINK_RECOMMENDED_SIZE(8)
+static uint8_t link_buf[I2C_LINK_BYTES];
+
+static const char *TAG = "MPU6050";
+
+static esp_err_t i2c_write(uint8_t reg, uint8_t data) {
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link_buf, sizeof(link_buf));
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write_byte(cmd, reg, true);
+    i2c_master_write_byte(cmd, data, true);
+    i2c_master_stop(cmd);
+    esp_err_t err = i2c_master_cmd_begin(I2C_PORT, cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+    i2c_cmd_link_delete_static(cmd);
+    return err;
+}
+
+static esp_err_t i2c_read(uint8_t reg, uint8_t *buf, size_t len) {
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link_buf, sizeof(link_buf));
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write_byte(cmd, reg, true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (MPU6050_ADDR << 1) | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, buf, len, I2C_MASTER_LAST_NACK);
+    i2c_master_stop(cmd);
+    esp_err_t err = i2c_master_cmd_begin(I2C_PORT, cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+    i2c_cmd_link_delete_static(cmd);
+    return err;
+}
+
+esp_err_t mpu6050_init(void) {
+    i2c_config_t i2c_conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = I2C_MASTER_SDA_IO,
+        .scl_io_num = I2C_MASTER_SCL_IO,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = I2C_MASTER_FREQ_HZ
+    };
+    i2c_param_config(I2C_PORT, &i2c_conf);
+    i2c_driver_install(I2C_PORT, I2C_MODE_MASTER, 0, 0, 0);
+
+    // Answers as soon as its I2C block is up, usually well under the datasheet's 30 ms
+    int64_t start = esp_timer_get_time();
+    uint8_t who = 0;
+    while (i2c_read(WHO_AM_I, &who, 1) != ESP_OK || who != WHO_AM_I_VALUE) {
+        if (esp_timer_get_time() - start > MPU6050_READY_TIMEOUT_MS * 1000) {
+            ESP_LOGW(TAG, "WHO_AM_I not answering (0x%02x)", who);
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+
+    // Wake MPU6050
+    return i2c_write(PWR_MGMT_1, 0);
+}
+
+esp_err_t mpu6050_read_gyro(int16_t gyro[3]) {
+    uint8_t data[6];
+    esp_err_t err = i2c_read(GYRO_XOUT_H, data, 6);
+    gyro[0] = (data[0] << 8) | data[1];
+    gyro[1] = (data[2] << 8) | data[3];
+    gyro[2] = (data[4] << 8) | data[5];
+    return err;
+}
+
+esp_err_t mpu6050_set_dlpf(uint8_t cfg) {
+    return i2c_write(CONFIG, cfg & 0x07);
+}
@@ -0,0 +1,15 @@
+// MPU6050 gyro over I2C
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// I2C bring-up; polls WHO_AM_I until the sensor answers, then wakes it
+esp_err_t mpu6050_init(void);
+
+// Raw gyro X, Y, Z
+esp_err_t mpu6050_read_gyro(int16_t gyro[3]);
+
+// Digital low-pass, DLPF_CFG 0 (260 Hz) .. 6 (5 Hz): deeper averaging inside the sensor
+esp_err_t mpu6050_set_dlpf(uint8_t cfg);
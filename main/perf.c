@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "perf.h"
+
+#define BUDGET_CYCLES ((uint32_t)CONFIG_FLEXSONIC_FRAME_BUDGET_US * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+
+static const char *TAG = "PERF";
+
+static const char *const kernel_names[PERF_KERNELS] = {
+    [PERF_ADC_READ] = "adc_read",
+    [PERF_FILTER]   = "filter",
+    [PERF_HEALTH]   = "health",
+    [PERF_IMU_READ] = "imu_read",
+    [PERF_CLASSIFY] = "classify",
+    [PERF_FRAME]    = "frame",
+    [PERF_STAGE_MASK]     = "stage_mask",
+    [PERF_STAGE_RULES]    = "stage_rules",
+    [PERF_STAGE_STEADY]   = "stage_steady",
+    [PERF_STAGE_CENTROID] = "stage_centroid",
+};
+
+typedef struct {
+    uint64_t sum;
+    uint32_t n;
+    uint32_t max;     // kept across dumps: worst case since boot
+} perf_stat_t;
+
+static perf_stat_t stats[PERF_KERNELS];
+static uint32_t overruns;
+static uint32_t stalled;
+
+static volatile bool guard_armed;
+static volatile int guard_allocs;
+static volatile size_t guard_last_size;
+
+void perf_add(perf_kernel_t k, uint32_t cycles) {
+    perf_stat_t *s = &stats[k];
+    s->sum += cycles;
+    s->n++;
+    if (cycles > s->max) s->max = cycles;
+    if (k == PERF_FRAME && cycles > BUDGET_CYCLES) overruns++;
+}
+
+uint32_t perf_overruns(void) {
+    return overruns;
+}
+
+void perf_stalled(void) {
+    stalled++;
+}
+
+#if CONFIG_HEAP_USE_HOOKS
+// Called by the heap for every allocation in any task, possibly with the cache disabled
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    if (!guard_armed) return;
+    guard_allocs++;
+    guard_last_size = size;
+}
+#endif
+
+void perf_arm_alloc_guard(void) {
+    guard_allocs = 0;
+    guard_armed = true;
+}
+
+int perf_allocs(void) {
+#if CONFIG_HEAP_USE_HOOKS
+    return guard_allocs;
+#else
+    return -1;
+#endif
+}
+
+void perf_dump(void) {
+    char line[448];
+    int pos = 0;
+
+    for (int k = 0; k < PERF_KERNELS && pos < (int)sizeof(line); k++) {
+        perf_stat_t *s = &stats[k];
+        pos += snprintf(line + pos, sizeof(line) - pos, "%s=%lu/%lu/%lu,", kernel_names[k],
+                        (unsigned long)(s->n ? s->sum / s->n : 0), (unsigned long)s->max, (unsigned long)s->n);
+        s->sum = 0;
+        s->n = 0;
+    }
+    int allocs = perf_allocs();
+    ESP_LOGI(TAG, "KERNEL_CYCLES %sbudget=%lu,overruns=%lu,stalled=%lu,allocs=%d", line,
+             (unsigned long)BUDGET_CYCLES, (unsigned long)overruns, (unsigned long)stalled, allocs);
+    if (allocs > 0) {
+        ESP_LOGE(TAG, "Heap used in the frame loop (last %u bytes)", (unsigned)guard_last_size);
+    }
+}
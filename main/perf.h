@@ -0,0 +1,45 @@
+// Per-kernel cycle counts, frame budget and the zero-allocation check of the frame loop
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_cpu.h"
+
+typedef enum {
+    PERF_ADC_READ,
+    PERF_FILTER,
+    PERF_HEALTH,      // flex sensor health monitor, same raw block as the filter
+    PERF_IMU_READ,
+    PERF_CLASSIFY,
+    PERF_FRAME,       // sum of the above, checked against CONFIG_FLEXSONIC_FRAME_BUDGET_US
+    PERF_STAGE_MASK,  // classify time again, by the cascade stage that settled the frame
+    PERF_STAGE_RULES,
+    PERF_STAGE_STEADY,
+    PERF_STAGE_CENTROID,
+    PERF_KERNELS,
+} perf_kernel_t;
+
+#define PERF_DUMP_FRAMES 100
+
+static inline uint32_t perf_now(void) {
+    return esp_cpu_get_cycle_count();
+}
+
+void perf_add(perf_kernel_t k, uint32_t cycles);
+
+// From here on every heap allocation is counted (needs CONFIG_HEAP_USE_HOOKS)
+void perf_arm_alloc_guard(void);
+
+// Allocations since perf_arm_alloc_guard(), -1 when the heap hooks are compiled out
+int perf_allocs(void);
+
+// Frames over budget since boot
+uint32_t perf_overruns(void);
+
+// A frame that overlapped a flash erase or write by another task: the caches
+// were off and the loop stalled on its own code. Counted apart, kept out of
+// the frame statistics and the budget.
+void perf_stalled(void);
+
+// Log one KERNEL_CYCLES line (avg/max/count per kernel, overruns, stalled, allocs) and restart the averages
+void perf_dump(void);
@@ -0,0 +1,107 @@
+#include <stddef.h>
+#include <string.h>
+#include "model_blob.h"
+#include "recorder.h"
+
+_Static_assert(sizeof(recorder_frame_t) == 32, "recorder frames are dumped as-is");
+
+const char *const recorder_trigger_names[RECORDER_TRIGGERS] = {
+    [RECORDER_TRIGGER_NONE] = "none", [RECORDER_TRIGGER_WRONG] = "wrong", [RECORDER_TRIGGER_CONSOLE] = "console",
+    [RECORDER_TRIGGER_SENSOR] = "sensor", [RECORDER_TRIGGER_OVERRUN] = "overrun", [RECORDER_TRIGGER_FLAP] = "flap",
+};
+
+void recorder_init(recorder_t *r, recorder_frame_t *buf, uint32_t cap) {
+    uint32_t pow2 = 1;
+    while (pow2 * 2 <= cap) pow2 *= 2;
+
+    memset(r, 0, sizeof(*r));
+    r->frames = buf;
+    r->mask = pow2 - 1;
+}
+
+bool recorder_trigger(recorder_t *r, recorder_trigger_t why) {
+    uint8_t none = RECORDER_TRIGGER_NONE;
+    if (recorder_frozen(r) != RECORDER_TRIGGER_NONE) return false;
+    return atomic_compare_exchange_strong(&r->request, &none, (uint8_t)why);
+}
+
+bool recorder_push(recorder_t *r, const recorder_frame_t *f) {
+    if (atomic_load_explicit(&r->frozen, memory_order_relaxed) != RECORDER_TRIGGER_NONE) {
+        r->missed++;
+        return false;
+    }
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    recorder_frame_t *slot = &r->frames[head & r->mask];
+    *slot = *f;
+
+    uint8_t why = atomic_load_explicit(&r->request, memory_order_relaxed);
+    if (why != RECORDER_TRIGGER_NONE) slot->flags |= RECORDER_MARK;
+    atomic_store_explicit(&r->head, head + 1, memory_order_relaxed);
+    if (why == RECORDER_TRIGGER_NONE) return false;
+
+    // Everything written above is visible to whoever sees the ring frozen
+    r->frozen_ms = f->t_ms;
+    atomic_store_explicit(&r->frozen, why, memory_order_release);
+    return true;
+}
+
+int recorder_runs(const recorder_t *r, const recorder_frame_t *run[2], uint32_t n[2]) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t cap = r->mask + 1;
+
+    if (head <= cap) {
+        run[0] = r->frames;
+        n[0] = head;
+        return head ? 1 : 0;
+    }
+    // Full ring: oldest at head, wrapping to the start
+    uint32_t split = head & r->mask;
+    run[0] = &r->frames[split];
+    n[0] = cap - split;
+    run[1] = r->frames;
+    n[1] = split;
+    return split ? 2 : 1;
+}
+
+void recorder_header(const recorder_t *r, uint32_t model_generation, recorder_dump_header_t *h) {
+    const recorder_frame_t *run[2];
+    uint32_t n[2];
+    int runs = recorder_runs(r, run, n);
+
+    memset(h, 0, sizeof(*h));
+    h->magic = RECORDER_MAGIC;
+    h->version = RECORDER_VERSION;
+    h->header_size = sizeof(*h);
+    h->frozen_ms = r->frozen_ms;
+    h->missed = r->missed;
+    h->model_generation = model_generation;
+    h->trigger = recorder_frozen(r);
+    for (int i = 0; i < runs; i++) {
+        h->n_frames += n[i];
+        h->frames_crc32 = model_blob_crc32(h->frames_crc32, run[i], n[i] * sizeof(recorder_frame_t));
+    }
+    h->header_crc32 = model_blob_crc32(0, h, offsetof(recorder_dump_header_t, header_crc32));
+}
+
+void recorder_thaw(recorder_t *r) {
+    atomic_store_explicit(&r->request, RECORDER_TRIGGER_NONE, memory_order_relaxed);
+    atomic_store_explicit(&r->frozen, RECORDER_TRIGGER_NONE, memory_order_release);
+}
+
+bool recorder_parse(const void *buf, size_t len, const recorder_dump_header_t **h,
+                    const recorder_frame_t **frames) {
+    const recorder_dump_header_t *hdr = buf;
+
+    if (len < sizeof(*hdr) || ((uintptr_t)buf & 3)) return false;
+    if (hdr->magic != RECORDER_MAGIC || hdr->version != RECORDER_VERSION || hdr->header_size != sizeof(*hdr)) {
+        return false;
+    }
+    if (model_blob_crc32(0, hdr, offsetof(recorder_dump_header_t, header_crc32)) != hdr->header_crc32) return false;
+    if (hdr->n_frames > (len - sizeof(*hdr)) / sizeof(recorder_frame_t)) return false;
+
+    const recorder_frame_t *f = (const recorder_frame_t *)(hdr + 1);
+    if (model_blob_crc32(0, f, hdr->n_frames * sizeof(*f)) != hdr->frames_crc32) return false;
+    *h = hdr;
+    *frames = f;
+    return true;
+}
@@ -0,0 +1,125 @@
+// Flight recorder: the last RECORDER frames the loop saw, what it decided and
+// what it played, kept in RAM at all times. A trigger freezes it for a dump to
+// flash and the console. The ring is IDF-free for the host build and bench.
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RECORDER_MAGIC   0x43455246u   // "FREC"
+#define RECORDER_VERSION 1
+
+// Track a vocabulary maps its "that was wrong" gesture to: never played, it
+// freezes the recorder instead
+#define RECORDER_WRONG_TRACK 999
+
+// recorder_frame_t.flags
+#define RECORDER_PLAYED      0x01   // play command sent this frame
+#define RECORDER_LEVEL       0x02   // governor level changed after this frame, level is the new one
+#define RECORDER_DEAD        0x04   // dead mask changed with this frame
+#define RECORDER_MARK        0x08   // the frame that triggered the freeze
+
+typedef enum {
+    RECORDER_TRIGGER_NONE,
+    RECORDER_TRIGGER_WRONG,      // the wearer's "that was wrong" gesture
+    RECORDER_TRIGGER_CONSOLE,    // "dump" on the console
+    RECORDER_TRIGGER_SENSOR,     // a flex sensor died
+    RECORDER_TRIGGER_OVERRUN,    // a frame over its compute budget
+    RECORDER_TRIGGER_FLAP,       // a different track played right after the last one
+    RECORDER_TRIGGERS,
+} recorder_trigger_t;
+
+// One frame, 32 bytes; gesture_frame_t plus the decision and playback
+typedef struct {
+    uint32_t t_ms;
+    int16_t flex[5];      // filtered, as classified
+    int16_t gyro[3];
+    int16_t track;        // decision: track, GESTURE_REST or GESTURE_UNKNOWN
+    int16_t candidate;    // best track before the threshold
+    int16_t played;       // track sent to the DFPlayer, 0 = none
+    uint8_t confidence;   // percent
+    uint8_t stage;        // gesture_stage_t
+    uint8_t dead_mask;
+    uint8_t level;        // governor_level_t
+    uint8_t flags;        // RECORDER_*
+    uint8_t reserved;
+} recorder_frame_t;
+
+// Dump layout: this header, then n_frames frames oldest first
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t n_frames;
+    uint32_t frozen_ms;       // device time of the trigger
+    uint32_t missed;          // frames not recorded while frozen, since boot
+    uint32_t model_generation;
+    uint8_t trigger;          // recorder_trigger_t
+    uint8_t reserved[3];
+    uint32_t frames_crc32;
+    uint32_t header_crc32;    // over every field above
+} recorder_dump_header_t;
+
+// Single writer (the frame loop). Other tasks only ask for a freeze; the
+// writer freezes after its own frame, so a frozen ring is never written to
+// and the reader needs no lock.
+typedef struct {
+    recorder_frame_t *frames;
+    uint32_t mask;            // capacity - 1, capacity a power of two
+    _Atomic uint32_t head;    // frames ever written
+    _Atomic uint8_t request;  // recorder_trigger_t asked for, applied on the next push
+    _Atomic uint8_t frozen;   // recorder_trigger_t that froze it, NONE while recording
+    uint32_t frozen_ms;
+    uint32_t missed;
+} recorder_t;
+
+extern const char *const recorder_trigger_names[RECORDER_TRIGGERS];
+
+// buf holds cap frames; cap is rounded down to a power of two
+void recorder_init(recorder_t *r, recorder_frame_t *buf, uint32_t cap);
+
+// Any task: freeze after the next frame; false if a freeze is already pending or on
+bool recorder_trigger(recorder_t *r, recorder_trigger_t why);
+
+// Frame loop: record one frame; returns true when this frame froze the ring
+bool recorder_push(recorder_t *r, const recorder_frame_t *f);
+
+static inline recorder_trigger_t recorder_frozen(const recorder_t *r) {
+    return (recorder_trigger_t)atomic_load_explicit(&r->frozen, memory_order_acquire);
+}
+
+// Frozen contents as up to two runs, oldest first; returns how many runs
+int recorder_runs(const recorder_t *r, const recorder_frame_t *run[2], uint32_t n[2]);
+
+// Header of the frozen contents, CRCs filled in
+void recorder_header(const recorder_t *r, uint32_t model_generation, recorder_dump_header_t *h);
+
+// Back to recording; pending requests are dropped
+void recorder_thaw(recorder_t *r);
+
+// Check a dump in memory; frames points into buf
+bool recorder_parse(const void *buf, size_t len, const recorder_dump_header_t **h,
+                    const recorder_frame_t **frames);
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+
+// Recorder of the frame loop, its partition and console
+extern recorder_t flight_recorder;
+
+// Find the partition, report a dump left by an earlier boot, start the dump and console tasks
+esp_err_t recorder_start(void);
+
+// Model generation written into dump headers
+void recorder_set_model(uint32_t generation);
+
+// Frame loop: recorder_push() into flight_recorder, waking the dump task when it froze
+void recorder_record(const recorder_frame_t *f);
+
+// Odd while the dump task is in a flash operation, bumped around each one: a
+// frame that saw it odd or changed overlapped a flash stall
+uint32_t recorder_flash_epoch(void);
+#endif
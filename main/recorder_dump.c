@@ -0,0 +1,246 @@
+// Flight recorder on the device: the ring itself, its flash partition, the
+// dump task and a line console on the log UART
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "spi_flash_mmap.h"
+#include "driver/uart.h"
+#include "sdkconfig.h"
+#include "recorder.h"
+
+#define RECORDER_PARTITION_SUBTYPE 0x41
+#define RECORDER_PARTITION_BYTES   0x10000   // "recorder" in partitions.csv
+#define RECORDER_DUMP_BYTES (sizeof(recorder_dump_header_t) + CONFIG_FLEXSONIC_RECORDER_FRAMES * sizeof(recorder_frame_t))
+#define RECORDER_TASK_STACK 3072
+#define RECORDER_TASK_PRIO  1           // below the frame loop; its flash steps still stall it, see save()
+#define CONSOLE_UART        CONFIG_ESP_CONSOLE_UART_NUM
+#define CONSOLE_LINE        32
+#define STREAM_BYTES        48          // dump bytes per FREC log line
+#define SAVE_CHUNK_BYTES    256         // one flash page per write
+
+static const char *TAG = "RECORDER";
+
+_Static_assert(RECORDER_DUMP_BYTES <= RECORDER_PARTITION_BYTES,
+               "CONFIG_FLEXSONIC_RECORDER_FRAMES: a full dump does not fit the recorder partition");
+
+recorder_t flight_recorder;
+static recorder_frame_t ring[CONFIG_FLEXSONIC_RECORDER_FRAMES];
+static const esp_partition_t *part;
+static uint32_t model_generation;
+
+static StaticTask_t dump_tcb, console_tcb;
+static StackType_t dump_stack[RECORDER_TASK_STACK], console_stack[RECORDER_TASK_STACK];
+static TaskHandle_t dump_task_handle;
+static _Atomic uint32_t flash_epoch;
+
+// Read one dump-sized chunk at a time from wherever the bytes live
+typedef esp_err_t (*read_fn_t)(size_t offset, void *buf, size_t len);
+
+// ------------------- STREAM -------------------
+// "FREC BEGIN n", then the dump as hex lines "FREC <offset> <hex>", then "FREC END";
+// session_load_log() on the host picks the last complete one out of a serial log
+static void stream(read_fn_t read_at, size_t len) {
+    uint8_t bytes[STREAM_BYTES];
+    char hex[2 * STREAM_BYTES + 1];
+
+    ESP_LOGI(TAG, "FREC BEGIN %u", (unsigned)len);
+    for (size_t off = 0; off < len; off += STREAM_BYTES) {
+        size_t n = len - off < STREAM_BYTES ? len - off : STREAM_BYTES;
+        if (read_at(off, bytes, n) != ESP_OK) break;
+        for (size_t i = 0; i < n; i++) snprintf(&hex[2 * i], 3, "%02x", bytes[i]);
+        ESP_LOGI(TAG, "FREC %06x %s", (unsigned)off, hex);
+    }
+    ESP_LOGI(TAG, "FREC END");
+}
+
+// The frozen ring laid out as a dump: header, then the runs oldest first
+static recorder_dump_header_t frozen_header;
+static const recorder_frame_t *frozen_run[2];
+static uint32_t frozen_n[2];
+
+static esp_err_t read_frozen(size_t offset, void *buf, size_t len) {
+    uint8_t *out = buf;
+    while (len > 0) {
+        const uint8_t *src;
+        size_t avail;
+        if (offset < sizeof(frozen_header)) {
+            src = (const uint8_t *)&frozen_header + offset;
+            avail = sizeof(frozen_header) - offset;
+        } else {
+            size_t at = offset - sizeof(frozen_header), first = frozen_n[0] * sizeof(recorder_frame_t);
+            src = at < first ? (const uint8_t *)frozen_run[0] + at : (const uint8_t *)frozen_run[1] + (at - first);
+            avail = at < first ? first - at : frozen_n[1] * sizeof(recorder_frame_t) - (at - first);
+        }
+        size_t n = len < avail ? len : avail;
+        memcpy(out, src, n);
+        out += n;
+        offset += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+// ------------------- FLASH -------------------
+// A flash operation turns the caches off on both cores, so the frame loop
+// stalls until it ends. Each one is bracketed by the epoch the loop checks,
+// and is followed by a tick for the loop to run in.
+static void flash_begin(void) {
+    atomic_fetch_add(&flash_epoch, 1);
+}
+
+static void flash_end(void) {
+    atomic_fetch_add(&flash_epoch, 1);
+    vTaskDelay(1);
+}
+
+static esp_err_t read_flash(size_t offset, void *buf, size_t len) {
+    flash_begin();
+    esp_err_t err = esp_partition_read(part, offset, buf, len);
+    flash_end();
+    return err;
+}
+
+// One sector erased, then one chunk written, at a time. Header last, so a
+// torn write leaves no valid dump rather than a corrupt one.
+static esp_err_t save(size_t len) {
+    static uint8_t chunk[SAVE_CHUNK_BYTES];
+    esp_err_t err = ESP_OK;
+
+    if (!part) return ESP_ERR_NOT_FOUND;
+    if (len > part->size) return ESP_ERR_INVALID_SIZE;
+
+    for (size_t off = 0; off < len && err == ESP_OK; off += SPI_FLASH_SEC_SIZE) {
+        flash_begin();
+        err = esp_partition_erase_range(part, off, SPI_FLASH_SEC_SIZE);
+        flash_end();
+    }
+    for (size_t off = sizeof(frozen_header); off < len && err == ESP_OK; off += SAVE_CHUNK_BYTES) {
+        size_t n = len - off < SAVE_CHUNK_BYTES ? len - off : SAVE_CHUNK_BYTES;
+        read_frozen(off, chunk, n);
+        flash_begin();
+        err = esp_partition_write(part, off, chunk, n);
+        flash_end();
+    }
+    if (err == ESP_OK) {
+        flash_begin();
+        err = esp_partition_write(part, 0, &frozen_header, sizeof(frozen_header));
+        flash_end();
+    }
+    return err;
+}
+
+// Header of the dump in flash, false when there is none
+static bool saved_header(recorder_dump_header_t *h) {
+    if (!part || read_flash(0, h, sizeof(*h)) != ESP_OK) return false;
+    return h->magic == RECORDER_MAGIC && h->version == RECORDER_VERSION && h->header_size == sizeof(*h)
+        && h->n_frames <= (part->size - sizeof(*h)) / sizeof(recorder_frame_t);
+}
+
+// ------------------- TASKS -------------------
+// Woken by the frame loop when a push froze the ring: save, stream, record again
+static void dump_task(void *arg) {
+    (void)arg;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        recorder_trigger_t why = recorder_frozen(&flight_recorder);
+        if (why == RECORDER_TRIGGER_NONE) continue;
+
+        int runs = recorder_runs(&flight_recorder, frozen_run, frozen_n);
+        if (runs < 2) frozen_n[1] = 0;
+        recorder_header(&flight_recorder, model_generation, &frozen_header);
+        size_t len = sizeof(frozen_header) + frozen_header.n_frames * sizeof(recorder_frame_t);
+        ESP_LOGW(TAG, "Frozen by %s at %lu ms: %lu frames", recorder_trigger_names[why],
+                 (unsigned long)frozen_header.frozen_ms, (unsigned long)frozen_header.n_frames);
+
+        esp_err_t err = save(len);
+        if (err != ESP_OK) ESP_LOGW(TAG, "Not saved to flash: %s", esp_err_to_name(err));
+        stream(read_frozen, len);
+        recorder_thaw(&flight_recorder);
+    }
+}
+
+static void console_command(const char *cmd) {
+    recorder_dump_header_t h;
+
+    if (!strcmp(cmd, "dump")) {
+        if (!recorder_trigger(&flight_recorder, RECORDER_TRIGGER_CONSOLE)) ESP_LOGW(TAG, "Dump already under way");
+    } else if (!strcmp(cmd, "last")) {
+        if (saved_header(&h)) stream(read_flash, sizeof(h) + h.n_frames * sizeof(recorder_frame_t));
+        else ESP_LOGW(TAG, "No dump in flash");
+    } else if (!strcmp(cmd, "rec")) {
+        uint32_t head = atomic_load(&flight_recorder.head);
+        ESP_LOGI(TAG, "RECORDER frames=%lu,capacity=%lu,missed=%lu,frozen=%s",
+                 (unsigned long)head, (unsigned long)(flight_recorder.mask + 1),
+                 (unsigned long)flight_recorder.missed, recorder_trigger_names[recorder_frozen(&flight_recorder)]);
+    } else if (cmd[0]) {
+        ESP_LOGI(TAG, "Commands: dump (freeze and dump the recorder), last (stream the dump in flash), rec (status)");
+    }
+}
+
+// Lines typed on the log UART
+static void console_task(void *arg) {
+    char line[CONSOLE_LINE];
+    size_t len = 0;
+
+    (void)arg;
+    while (1) {
+        uint8_t c;
+        if (uart_read_bytes(CONSOLE_UART, &c, 1, portMAX_DELAY) != 1) continue;
+        if (c == '\r' || c == '\n') {
+            line[len] = '\0';
+            console_command(line);
+            len = 0;
+        } else if (len + 1 < sizeof(line)) {
+            line[len++] = c;
+        }
+    }
+}
+
+// ------------------- API -------------------
+esp_err_t recorder_start(void) {
+    recorder_dump_header_t h;
+
+    recorder_init(&flight_recorder, ring, CONFIG_FLEXSONIC_RECORDER_FRAMES);
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, RECORDER_PARTITION_SUBTYPE, "recorder");
+    if (!part) {
+        ESP_LOGW(TAG, "No recorder partition, dumps are only streamed");
+    } else if (part->size < RECORDER_DUMP_BYTES) {
+        // A partition table older than this build; save() refuses what does not fit
+        ESP_LOGW(TAG, "Recorder partition holds %lu bytes, a full dump takes %lu: only short dumps reach flash",
+                 (unsigned long)part->size, (unsigned long)RECORDER_DUMP_BYTES);
+    }
+    if (saved_header(&h)) {
+        ESP_LOGI(TAG, "Dump from an earlier boot in flash: %lu frames, %s at %lu ms (\"last\" streams it)",
+                 (unsigned long)h.n_frames, h.trigger < RECORDER_TRIGGERS ? recorder_trigger_names[h.trigger] : "?",
+                 (unsigned long)h.frozen_ms);
+    }
+
+    // Before the first frame: the driver allocates, the frame loop must not
+    esp_err_t err = uart_driver_install(CONSOLE_UART, 256, 0, 0, NULL, 0);
+    if (err == ESP_OK) {
+        xTaskCreateStatic(console_task, "console", RECORDER_TASK_STACK, NULL, RECORDER_TASK_PRIO,
+                          console_stack, &console_tcb);
+    } else {
+        ESP_LOGW(TAG, "No console: %s", esp_err_to_name(err));
+    }
+    dump_task_handle = xTaskCreateStatic(dump_task, "recorder", RECORDER_TASK_STACK, NULL, RECORDER_TASK_PRIO,
+                                         dump_stack, &dump_tcb);
+    ESP_LOGI(TAG, "Recording the last %lu frames", (unsigned long)(flight_recorder.mask + 1));
+    return err;
+}
+
+uint32_t recorder_flash_epoch(void) {
+    return atomic_load(&flash_epoch);
+}
+
+void recorder_set_model(uint32_t generation) {
+    model_generation = generation;
+}
+
+void recorder_record(const recorder_frame_t *f) {
+    if (recorder_push(&flight_recorder, f) && dump_task_handle) xTaskNotifyGive(dump_task_handle);
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "startup.h"
+
+#define STARTUP_TASK_STACK 3072
+#define STARTUP_FAIL_SHIFT 16
+
+static const char *TAG = "STARTUP";
+
+typedef struct {
+    const char *event;
+    int64_t us;
+} startup_mark_t;
+
+static const startup_step_t *step_list;
+static EventGroupHandle_t step_events;
+
+// Everything allocated up front, bring-up never touches the heap
+static StaticEventGroup_t step_events_buf;
+static StaticTask_t step_tcbs[STARTUP_MAX_STEPS];
+static StackType_t step_stacks[STARTUP_MAX_STEPS][STARTUP_TASK_STACK];
+static startup_mark_t marks[STARTUP_MAX_MARKS];
+static volatile int n_marks;
+static portMUX_TYPE marks_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void startup_mark(const char *event) {
+    // esp_timer counts from power-on, so the ROM/bootloader time is included
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&marks_lock);
+    if (n_marks < STARTUP_MAX_MARKS) {
+        marks[n_marks].event = event;
+        marks[n_marks].us = now;
+        n_marks++;
+    }
+    portEXIT_CRITICAL(&marks_lock);
+}
+
+static void startup_task(void *arg) {
+    int i = (int)(intptr_t)arg;
+    esp_err_t err = step_list[i].fn();
+
+    startup_mark(step_list[i].name);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s failed: %s", step_list[i].name, esp_err_to_name(err));
+    }
+    xEventGroupSetBits(step_events, STARTUP_STEP(i) << (err == ESP_OK ? 0 : STARTUP_FAIL_SHIFT));
+    vTaskDelete(NULL);
+}
+
+void startup_begin(const startup_step_t *steps, int n) {
+    step_list = steps;
+    step_events = xEventGroupCreateStatic(&step_events_buf);
+    startup_mark("app_main");
+
+    for (int i = 0; i < n && i < STARTUP_MAX_STEPS; i++) {
+        xTaskCreateStatic(startup_task, steps[i].name, STARTUP_TASK_STACK, (void *)(intptr_t)i,
+                          uxTaskPriorityGet(NULL), step_stacks[i], &step_tcbs[i]);
+    }
+}
+
+bool startup_wait(uint32_t mask, TickType_t timeout) {
+    TickType_t start = xTaskGetTickCount();
+    EventBits_t bits = xEventGroupGetBits(step_events);
+
+    // A step is done once either its ok or its fail bit is set
+    uint32_t pending;
+    while ((pending = mask & ~(bits | (bits >> STARTUP_FAIL_SHIFT))) != 0) {
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= timeout) return false;
+        bits = xEventGroupWaitBits(step_events, pending | (pending << STARTUP_FAIL_SHIFT),
+                                   pdFALSE, pdFALSE, timeout - waited);
+    }
+    return (bits & mask) == mask;
+}
+
+void startup_dump(void) {
+    char line[256] = "";
+    int pos = 0;
+
+    portENTER_CRITICAL(&marks_lock);
+    int n = n_marks;
+    portEXIT_CRITICAL(&marks_lock);
+
+    for (int i = 0; i < n && pos < (int)sizeof(line); i++) {
+        pos += snprintf(line + pos, sizeof(line) - pos, "%s%s=%lld", i ? "," : "",
+                        marks[i].event, (long long)(marks[i].us / 1000));
+    }
+    ESP_LOGI(TAG, "BOOT_TIMELINE %s", line);
+}
@@ -0,0 +1,32 @@
+// Parallel peripheral bring-up and boot timeline
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#define STARTUP_MAX_STEPS 4     // each reserves a static task stack
+#define STARTUP_MAX_MARKS 16
+
+typedef esp_err_t (*startup_fn_t)(void);
+
+typedef struct {
+    const char *name;
+    startup_fn_t fn;      // must poll for readiness itself, not sleep a fixed time
+} startup_step_t;
+
+#define STARTUP_STEP(i) (1u << (i))
+
+// Run every step in its own task and return immediately
+void startup_begin(const startup_step_t *steps, int n);
+
+// Block until all steps in mask finished; true if they all succeeded
+bool startup_wait(uint32_t mask, TickType_t timeout);
+
+// Record a named point on the boot timeline (ms since power-on)
+void startup_mark(const char *event);
+
+// Log the timeline as one BOOT_TIMELINE line for scripts to pick up
+void startup_dump(void);
@@ -1,9 +1,11 @@
+import os
 import re
 import csv
 
-# Absolute paths
-input_file = r"E:\Janhavi\SRA\flexsonic\data collection\data.txt"
-output_file = r"E:\Janhavi\SRA\flexsonic\data processed\gesture_parsed.csv"
+# Paths relative to the repo; ingest_sessions.py builds the columnar store from the same log
+repo = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+input_file = os.path.join(repo, "data collection", "data.txt")
+output_file = os.path.join(repo, "data processed", "gesture_parsed.csv")
 
 # Regex patterns
 flex_pattern = re.compile(
@@ -2,7 +2,7 @@ import pandas as pd
 import os
 
 # Define paths
-base_path = r"E:\Janhavi\SRA\flexsonic\data processed"
+base_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "data processed")
 input_file = os.path.join(base_path, "data_with_clusters.csv")
 output_file = os.path.join(base_path, "gesture_labeled.csv")
 
@@ -30,6 +30,9 @@ cluster_to_audio = {
     2: 6   # all_bent → 0006.mp3
 }
 
+# Below this centroid margin the hand is between gestures: don't play
+MIN_CONFIDENCE = 0.35
+
 while True:
     try:
         # === Read line from ESP32 ===
@@ -48,11 +51,16 @@ while True:
         # Scale before prediction
         X_scaled = scaler.transform(X_new)
 
-        # Predict cluster
+        # Nearest cluster, confidence from the margin to the second nearest
+        # (same score as gesture_classify() in the firmware)
+        dist = np.sort(kmeans.transform(X_scaled)[0])
         cluster = int(kmeans.predict(X_scaled)[0])
+        confidence = (dist[1] - dist[0]) / (dist[1] + dist[0] + 1e-6) if len(dist) > 1 else 1.0
         gesture = cluster_to_label.get(cluster, "unknown")
 
-        print(f" Detected: Cluster {cluster} = {gesture}")
+        print(f" Detected: Cluster {cluster} = {gesture} (confidence {confidence:.2f})")
+        if confidence < MIN_CONFIDENCE:
+            continue
 
         # Play mapped audio
         if cluster in cluster_to_audio:
@@ -6,30 +6,30 @@ from sklearn.cluster import KMeans
 from sklearn.decomposition import PCA
 import matplotlib.pyplot as plt
 import joblib
+import session_store as ss
 
 parser = argparse.ArgumentParser()
-parser.add_argument("infile")
+parser.add_argument("infile", help="CSV, .fses session store, or a folder of stores")
 parser.add_argument("--k", type=int, default=6, help="Number of clusters (gestures)")
 parser.add_argument("--use_gyro", action="store_true", help="Include GyroX,Y,Z features")
 args = parser.parse_args()
 
-# === Load data ===
-df = pd.read_csv(args.infile)
-
-# Flex columns
+# Flex + gyro columns (optional)
 flex_cols = ["Thumb", "Index", "Middle", "Ring", "Pinky"]
-for c in flex_cols:
-    if c not in df.columns:
-        df[c] = 0
-
-# Gyro columns (optional)
 gyro_cols = ["GyroX", "GyroY", "GyroZ"]
-for c in gyro_cols:
-    if c not in df.columns:
-        df[c] = 0
-
-# Select features
 features = flex_cols + gyro_cols if args.use_gyro else flex_cols
+from_store = args.infile.endswith(".fses") or os.path.isdir(args.infile)
+
+# === Load data ===
+if from_store:
+    # Memory-mapped columns: only the selected channels are read, nothing is parsed
+    X = ss.load_matrix(args.infile, ss.FLEX + ss.GYRO if args.use_gyro else ss.FLEX)
+    df = pd.DataFrame(X, columns=features)
+else:
+    df = pd.read_csv(args.infile)
+    for c in features:
+        if c not in df.columns:
+            df[c] = 0
 
 # Clean: drop rows where all flex = 0
 df = df[df[flex_cols].sum(axis=1) > 0].reset_index(drop=True)
@@ -53,11 +53,12 @@ joblib.dump(kmeans, os.path.join(models_dir, "kmeans.pkl"))
 joblib.dump(scaler, os.path.join(models_dir, "scaler.pkl"))
 print("💾 Saved KMeans + scaler to ../models/")
 
-# Save labelled CSV to the correct "data processed" folder
-out_csv = os.path.join("..", "data processed", "data_with_clusters.csv")
-os.makedirs(os.path.dirname(out_csv), exist_ok=True)
-df.to_csv(out_csv, index=False)
-print("📁 Saved labelled data to:", out_csv)
+# Save labelled CSV to the correct "data processed" folder; a store is not copied out again
+if not from_store:
+    out_csv = os.path.join("..", "data processed", "data_with_clusters.csv")
+    os.makedirs(os.path.dirname(out_csv), exist_ok=True)
+    df.to_csv(out_csv, index=False)
+    print("📁 Saved labelled data to:", out_csv)
 
 # === Visualization ===
 pca = PCA(n_components=2)
@@ -0,0 +1,252 @@
+import argparse, json, os, struct, subprocess, tempfile, zlib
+import joblib
+
+# Must match main/model_blob.h
+MAGIC = 0x4C444D46  # "FMDL"
+VERSION = 3
+HEADER_FMT = "<IHHIIIBBBBBBBB" # everything before header_crc32
+RULE_FMT = "<HBBhhhhhh"        # model_rule_t
+FINGERS = {"thumb": 1, "index": 2, "middle": 4, "ring": 8, "pinky": 16}
+RULE_GYRO, RULE_REPEAT, RULE_REARM = 0x01, 0x02, 0x04
+SLOTS = ("model_a", "model_b")  # partitions.csv; model_store.c keeps model_a on a generation tie
+
+# Trigger cascades of the firmware variants, first match wins. Track 999 is
+# the "that was wrong" gesture (main/recorder.h): never played, it freezes the
+# flight recorder. "sentence" is also the firmware's built-in vocabulary:
+#   python 5_export_model_blob.py --vocab sentence --header ../main/builtin_vocab.h
+VOCABULARIES = {
+    "sentence": [  # 4_sentence_gesture.c
+        {"track": 23, "fingers": ["index"]},
+        {"track": 5, "fingers": ["thumb"]},
+        {"track": 7, "fingers": ["middle"]},
+        {"track": 8, "fingers": ["ring"]},
+        {"track": 25, "fingers": ["pinky"]},
+        {"track": 6, "gyro": [1000, 15000, 15000], "rearm": 400},
+    ],
+    "numbers": [  # 5_numbers_gesture.c
+        {"track": 17, "fingers": ["thumb", "middle", "ring", "pinky"], "lo": 500, "hi": 4000, "repeat": True},
+        {"track": 16, "fingers": ["thumb", "ring", "pinky"], "lo": 500, "hi": 4000, "repeat": True},
+        {"track": 15, "fingers": ["index", "thumb"], "lo": 500, "hi": 4000, "repeat": True},
+        {"track": 1, "fingers": ["thumb"], "lo": 500, "hi": 4000},
+        {"track": 6, "gyro": [1000, 15000, 15000], "repeat": True},
+    ],
+    "flex": [  # 1_flex.c
+        {"track": 1, "fingers": ["index"]},
+        {"track": 2, "fingers": ["thumb"]},
+        {"track": 3, "fingers": ["middle"]},
+        {"track": 4, "fingers": ["ring"]},
+        {"track": 5, "fingers": ["pinky"]},
+    ],
+}
+
+# Same mapping as 3_predict_and_audio.py
+CLUSTER_TO_AUDIO = {5: 1, 1: 2, 4: 3, 0: 4, 3: 5, 2: 6}
+
+# Confidence a gesture needs before it is played, unless --thresholds says otherwise
+DEFAULT_MIN_CONF = 0.35
+
+
+def min_conf(thresholds, track):
+    """Acceptance threshold in permille for a track"""
+    return int(round(1000 * thresholds.get(str(track), thresholds.get("default", DEFAULT_MIN_CONF))))
+
+
+def cluster_radii(scaler, kmeans, csv_path, percentile):
+    """Per-cluster distance (scaled units) covering `percentile` % of its training frames"""
+    import numpy as np
+    import pandas as pd
+
+    df = pd.read_csv(csv_path)
+    cols = ["Thumb", "Index", "Middle", "Ring", "Pinky", "GyroX", "GyroY", "GyroZ"][:kmeans.n_features_in_]
+    for c in cols:
+        if c not in df.columns:
+            df[c] = 0
+    df = df[df[cols[:5]].sum(axis=1) > 0]
+    X = scaler.transform(df[cols].astype(float).values)
+    labels = kmeans.predict(X)
+    dist = np.linalg.norm(X - kmeans.cluster_centers_[labels], axis=1)
+    return [float(np.percentile(dist[labels == c], percentile)) if np.any(labels == c) else 0.0
+            for c in range(kmeans.n_clusters)]
+
+
+def rule_fields(rule, thresholds):
+    """model_rule_t fields in declaration order"""
+    mask = 0
+    for f in rule.get("fingers", []):
+        mask |= FINGERS[f]
+    flags = (RULE_GYRO if "gyro" in rule else 0) | (RULE_REPEAT if rule.get("repeat") else 0)
+    gx, gy, gz = rule.get("gyro", [0, 0, 0])
+    lo = rule.get("lo", 1000)
+    if "gyro" in rule and "rearm" in rule:
+        # Gyro rules have no flex range: flex_lo carries the re-arm margin
+        flags |= RULE_REARM
+        lo = rule["rearm"]
+    return (rule["track"], mask, flags, lo, rule.get("hi", 3500), gx, gy, gz,
+            min_conf(thresholds, rule["track"]))
+
+
+def pack_rule(rule, thresholds):
+    return struct.pack(RULE_FMT, *rule_fields(rule, thresholds))
+
+
+def c_bits(value, names):
+    return " | ".join(name for bit, name in names if value & bit) or "0"
+
+
+def write_header(path, vocab, rules, thresholds):
+    """The vocabulary as a model_rule_t initializer, for firmware that runs without a blob"""
+    fingers = [(bit, "FINGER_" + name.upper()) for name, bit in FINGERS.items()]
+    flags = [(RULE_GYRO, "MODEL_RULE_GYRO"), (RULE_REPEAT, "MODEL_RULE_REPEAT"), (RULE_REARM, "MODEL_RULE_REARM")]
+    lines = [f"// Generated by ml/5_export_model_blob.py --vocab {vocab} --header, do not edit",
+             "// Vocabulary used when no valid blob is flashed, first match wins",
+             "", "#pragma once", "", '#include "model_blob.h"', "",
+             "static const model_rule_t builtin_rules[] = {"]
+    for r in rules:
+        track, mask, flag, lo, hi, gx, gy, gz, conf = rule_fields(r, thresholds)
+        lines.append(f"    {{ .track = {track}, .flex_mask = {c_bits(mask, fingers)}, .flags = {c_bits(flag, flags)}, "
+                     f".flex_lo = {lo}, .flex_hi = {hi}, .gyro_x = {gx}, .gyro_y = {gy}, .gyro_z = {gz}, "
+                     f".min_conf = {conf} }},")
+    lines += ["};", ""]
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def build_blob(rules, scaler=None, kmeans=None, cluster_to_audio=None, generation=1,
+               thresholds=None, radii=None, pipeline=None):
+    """pipeline: optional {"hold": frames, "median_n", "iir_shift", "decimation"} the model was selected with"""
+    thresholds = thresholds or {}
+    pipeline = pipeline or {}
+    if kmeans is not None:
+        centers = kmeans.cluster_centers_
+        n_clusters, n_features = centers.shape
+        mean, scale = scaler.mean_, scaler.scale_
+    else:
+        n_clusters, n_features = 0, 5
+        mean, scale, centers = [0.0] * 5, [1.0] * 5, []
+
+    payload = struct.pack(f"<{n_features}f", *mean)
+    payload += struct.pack(f"<{n_features}f", *scale)
+    for c in centers:
+        payload += struct.pack(f"<{n_features}f", *c)
+    payload += struct.pack(f"<{n_clusters}f", *(radii or [0.0] * n_clusters))
+    tracks = [cluster_to_audio.get(c, 0) for c in range(n_clusters)]
+    payload += struct.pack(f"<{n_clusters}H", *tracks)
+    payload += struct.pack(f"<{n_clusters}H", *(min_conf(thresholds, t) for t in tracks))
+    payload += b"\0" * (-len(payload) % 4)
+    payload += b"".join(pack_rule(r, thresholds) for r in rules)
+
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, struct.calcsize(HEADER_FMT) + 4, generation,
+                         len(payload), zlib.crc32(payload), n_features, n_clusters, len(rules),
+                         pipeline.get("hold", 0), pipeline.get("median_n", 0), pipeline.get("iir_shift", 0),
+                         pipeline.get("decimation", 0), 0)
+    return header + struct.pack("<I", zlib.crc32(header)) + payload
+
+
+def slot_generation(data):
+    """Generation of the blob in a slot image, None when the firmware would reject it"""
+    n = struct.calcsize(HEADER_FMT)
+    if len(data) < n + 4:
+        return None
+    magic, version, header_size, generation, payload_size, payload_crc = struct.unpack_from(HEADER_FMT, data)[:6]
+    if magic != MAGIC or version != VERSION or header_size != n + 4:
+        return None
+    if struct.unpack_from("<I", data, n)[0] != zlib.crc32(data[:n]):
+        return None
+    payload = data[header_size:header_size + payload_size]
+    if len(payload) != payload_size or zlib.crc32(payload) != payload_crc:
+        return None
+    return generation
+
+
+def read_slots(port=None):
+    """{slot: generation or None} read back from the glove with parttool.py"""
+    port_args = ["--port", port] if port else []
+    gens = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        for slot in SLOTS:
+            path = os.path.join(tmp, slot + ".bin")
+            try:
+                subprocess.run(["parttool.py", *port_args, "read_partition", "--partition-name", slot,
+                                "--output", path], check=True, stdout=subprocess.DEVNULL)
+            except (OSError, subprocess.CalledProcessError) as e:
+                raise SystemExit(f"❌ Could not read {slot} ({e}); pass --slot and --generation instead")
+            with open(path, "rb") as f:
+                gens[slot] = slot_generation(f.read())
+    return gens
+
+
+def pick_slot(gens):
+    """(slot, generation) that wins the next boot without overwriting the active model"""
+    valid = {s: g for s, g in gens.items() if g is not None}
+    if not valid:
+        return SLOTS[0], 1
+    active = max(SLOTS, key=lambda s: (valid.get(s, -1), s == SLOTS[0]))
+    return SLOTS[1] if active == SLOTS[0] else SLOTS[0], max(valid.values()) + 1
+
+
+def deploy_target(slot="auto", generation=None, port=None):
+    """Slot and generation to flash: the inactive slot at max + 1 unless both are given"""
+    if slot != "auto" and generation is not None:
+        return slot, generation
+    gens = read_slots(port)
+    print("Slots on the glove: " + ", ".join(f"{s} gen {g}" if g is not None else f"{s} empty"
+                                               for s, g in gens.items()))
+    auto_slot, auto_gen = pick_slot(gens)
+    return auto_slot if slot == "auto" else slot, auto_gen if generation is None else generation
+
+
+def print_flash_command(path, slot, port=None):
+    port_arg = f"--port {port} " if port else ""
+    print(f"  parttool.py {port_arg}write_partition --partition-name {slot} --input {path}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--vocab", default="sentence", help="sentence | numbers | flex | path to a JSON rule list")
+    parser.add_argument("--models", default=os.path.join("..", "models"), help="Folder with kmeans.pkl + scaler.pkl")
+    parser.add_argument("--no_model", action="store_true", help="Export the trigger cascade only")
+    parser.add_argument("--slot", default="auto", choices=("auto",) + SLOTS,
+                        help="Slot to flash; auto reads both slots and picks the inactive one")
+    parser.add_argument("--generation", type=int,
+                        help="Higher generation wins at boot; default one above both slots")
+    parser.add_argument("--port", help="Serial port of the glove, for parttool.py")
+    parser.add_argument("--thresholds", help="JSON {track: confidence} from flexsonic_replay --calibrate")
+    parser.add_argument("--data", help="Training CSV; bounds every cluster to the radius of its frames")
+    parser.add_argument("--radius_pct", type=float, default=99.0, help="Percentile of frames inside the radius")
+    parser.add_argument("--out", default=os.path.join("..", "models", "model.bin"))
+    parser.add_argument("--header", help="Write the vocabulary as a C header (main/builtin_vocab.h) instead of a blob")
+    args = parser.parse_args()
+
+    if args.vocab in VOCABULARIES:
+        rules = VOCABULARIES[args.vocab]
+    else:
+        with open(args.vocab) as f:
+            rules = json.load(f)
+
+    thresholds = {}
+    if args.thresholds:
+        with open(args.thresholds) as f:
+            thresholds = json.load(f)
+
+    if args.header:
+        write_header(args.header, os.path.basename(args.vocab), rules, thresholds)
+        print(f"💾 Saved {len(rules)} rules to {args.header}")
+        raise SystemExit(0)
+
+    scaler = kmeans = radii = None
+    if not args.no_model:
+        kmeans = joblib.load(os.path.join(args.models, "kmeans.pkl"))
+        scaler = joblib.load(os.path.join(args.models, "scaler.pkl"))
+        if args.data:
+            radii = cluster_radii(scaler, kmeans, args.data, args.radius_pct)
+
+    slot, generation = deploy_target(args.slot, args.generation, args.port)
+    blob = build_blob(rules, scaler, kmeans, CLUSTER_TO_AUDIO, generation, thresholds, radii)
+    if len(blob) > 64 * 1024:
+        raise SystemExit("❌ Blob does not fit the 64K model partition")
+    with open(args.out, "wb") as f:
+        f.write(blob)
+
+    print(f"💾 Saved {len(blob)} byte model blob (gen {generation}) to {args.out}")
+    print(f"Flash it into {slot}; it takes over at the next boot:")
+    print_flash_command(args.out, slot, args.port)
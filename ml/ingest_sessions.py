@@ -0,0 +1,131 @@
+import argparse, csv, os, re, time
+from multiprocessing import Pool
+import numpy as np
+import session_store as ss
+
+# Convert serial logs (data.txt, monitor captures) and CSVs into one columnar .fses store.
+# Large logs are split into chunks at line boundaries and parsed on every core.
+#   python ingest_sessions.py "../data collection/data.txt" "../data processed/gesture_labeled.csv" --out ../sessions/sessions.fses
+
+FRAME_MS = 300   # firmware loop period, used when a capture has no timestamps
+
+LOG_LINE = re.compile(
+    rb"(?:[IWE] \((\d+)\)[^\n]*?)?Thumb:(\d+)\s*\|\s*Index:(\d+)\s*\|\s*Middle:(\d+)\s*\|\s*Ring:(\d+)\s*\|\s*Pinky:(\d+)"
+    rb"(?:\s*\|\|\s*Gyro X:(-?\d+)\s*Y:(-?\d+)\s*Z:(-?\d+))?")
+
+LOG_COLUMNS = ["t_ms"] + ss.FLEX + ss.GYRO
+
+
+def empty_columns(n):
+    cols = {name: np.zeros(n, dtype) for name, dtype in ss.COLUMNS}
+    cols["label"][:] = ss.LABEL_UNKNOWN
+    return cols
+
+
+def parse_log_chunk(task):
+    """Frames of one byte range of a serial log"""
+    path, start, end = task
+    with open(path, "rb") as f:
+        f.seek(start)
+        data = f.read(end - start)
+    rows = [tuple(int(g) if g else 0 for g in m.groups()) for m in LOG_LINE.finditer(data)]
+    cols = empty_columns(len(rows))
+    if rows:
+        table = np.array(rows, dtype=np.int64)
+        for i, name in enumerate(LOG_COLUMNS):
+            cols[name][:] = table[:, i]
+    return path, start, cols
+
+
+def parse_csv(task):
+    """Frames of a CSV with any of the column spellings in ss.ALIASES"""
+    path, start, _ = task
+    with open(path, newline="") as f:
+        reader = csv.reader(f)
+        header = [ss.ALIASES.get(h.strip().lower()) for h in next(reader)]
+        rows = [r for r in reader if r]
+    cols = empty_columns(len(rows))
+    cols["t_ms"][:] = np.arange(len(rows)) * FRAME_MS
+    seen = set()
+    for j, name in enumerate(header):
+        # First spelling wins: processed CSVs carry Gyro_X and a zero-filled GyroX
+        if name is None or name in seen:
+            continue
+        seen.add(name)
+        values = [r[j] if j < len(r) else "" for r in rows]
+        if name == "label":
+            cols[name][:] = [ss.LABEL_TRACKS.get(v, ss.LABEL_UNKNOWN) for v in values]
+        else:
+            cols[name][:] = [int(float(v)) if v else 0 for v in values]
+    return path, start, cols
+
+
+def chunk_tasks(path, chunk_bytes):
+    """Byte ranges of a log, each ending on a newline"""
+    size = os.path.getsize(path)
+    tasks, start = [], 0
+    with open(path, "rb") as f:
+        while start < size:
+            f.seek(min(start + chunk_bytes, size))
+            f.readline()
+            end = min(f.tell(), size) if start + chunk_bytes < size else size
+            tasks.append((path, start, end))
+            start = end
+    return tasks
+
+
+def split_boots(name, cols):
+    """A capture spanning several boots becomes one session per boot (timestamps restart)"""
+    t = cols["t_ms"].astype(np.int64)
+    cuts = [0] + list(np.nonzero(np.diff(t) < 0)[0] + 1) + [len(t)]
+    parts = [(a, b) for a, b in zip(cuts, cuts[1:]) if b > a]
+    for k, (a, b) in enumerate(parts):
+        yield (name if len(parts) == 1 else f"{name}#{k}"), {c: v[a:b] for c, v in cols.items()}
+
+
+def input_files(paths):
+    for p in paths:
+        if os.path.isdir(p):
+            for root, _, files in os.walk(p):
+                yield from (os.path.join(root, f) for f in sorted(files) if f.endswith((".txt", ".log", ".csv")))
+        else:
+            yield p
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("inputs", nargs="+", help="Serial logs (.txt/.log), CSVs, or folders of them")
+    parser.add_argument("--out", default=os.path.join("..", "sessions", "sessions.fses"))
+    parser.add_argument("--jobs", type=int, default=os.cpu_count())
+    parser.add_argument("--chunk_mb", type=float, default=8, help="Log bytes per parse task")
+    args = parser.parse_args()
+
+    start = time.time()
+    files = list(input_files(args.inputs))
+    log_tasks, csv_tasks = [], []
+    for path in files:
+        if path.endswith(".csv"):
+            csv_tasks.append((path, 0, 0))
+        else:
+            log_tasks += chunk_tasks(path, int(args.chunk_mb * 1024 * 1024))
+
+    with Pool(args.jobs) as pool:
+        results = pool.map(parse_log_chunk, log_tasks) + pool.map(parse_csv, csv_tasks)
+
+    # Reassemble chunks per file in byte order, keep the input order
+    sessions = []
+    for path in files:
+        parts = sorted((r for r in results if r[0] == path), key=lambda r: r[1])
+        cols = {name: np.concatenate([p[2][name] for p in parts]) for name, _ in ss.COLUMNS}
+        source = ss.SOURCE_CSV if path.endswith(".csv") else ss.SOURCE_LOG
+        if source == ss.SOURCE_LOG and len(cols["t_ms"]) and not cols["t_ms"].any():
+            # Log captured without the "I (ms)" prefix: space frames like the CSVs
+            cols["t_ms"][:] = np.arange(len(cols["t_ms"])) * FRAME_MS
+        for name, part in split_boots(os.path.basename(path), cols):
+            sessions.append((name, source, part))
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.out)), exist_ok=True)
+    ss.write_store(args.out, sessions)
+    n = sum(len(c["t_ms"]) for _, _, c in sessions)
+    print(f"💾 {len(sessions)} sessions, {n} frames from {len(files)} files -> {args.out} "
+          f"({time.time() - start:.2f} s, {args.jobs} jobs)")
@@ -0,0 +1,140 @@
+"""Columnar session store (.fses), shared by ingestion, training, plotting and host/session_store.c
+
+Layout (little-endian):
+  header      64 bytes   magic "FSES", version, header_size, n_columns, n_frames, n_sessions,
+                         column_dir_offset, index_offset
+  column dir  32 bytes per column: name[16], numpy dtype[4] ("<u4", "<i2"), offset u64, reserved u32
+  columns     one contiguous array per channel over all frames, 64-byte aligned
+  index       96 bytes per session: name[64], first frame u64, frame count u64, source u32, reserved
+
+Every channel has one canonical name, whatever the capture called it (Gyro_X, GyroX, flex1, ...).
+Labels are track numbers as in host/session.c: 0 = rest, -1 = unknown.
+"""
+import os, struct
+import numpy as np
+
+MAGIC = b"FSES"
+VERSION = 1
+HEADER_FMT = "<4sHHIQQQQ"          # padded to HEADER_SIZE
+HEADER_SIZE = 64
+COLUMN_FMT = "<16s4sQI"
+INDEX_FMT = "<64sQQI12x"
+ALIGN = 64
+
+COLUMNS = [
+    ("t_ms", "<u4"),
+    ("thumb", "<i2"), ("index", "<i2"), ("middle", "<i2"), ("ring", "<i2"), ("pinky", "<i2"),
+    ("gyro_x", "<i2"), ("gyro_y", "<i2"), ("gyro_z", "<i2"),
+    ("label", "<i2"),
+]
+FLEX = ["thumb", "index", "middle", "ring", "pinky"]
+GYRO = ["gyro_x", "gyro_y", "gyro_z"]
+
+# Names used across data.py, 1_raw_to_csv.py and the processed CSVs
+ALIASES = {
+    "thumb": "thumb", "flex1": "thumb",
+    "index": "index", "flex2": "index",
+    "middle": "middle", "flex3": "middle",
+    "ring": "ring", "flex4": "ring",
+    "pinky": "pinky", "flex5": "pinky",
+    "gyro_x": "gyro_x", "gyrox": "gyro_x",
+    "gyro_y": "gyro_y", "gyroy": "gyro_y",
+    "gyro_z": "gyro_z", "gyroz": "gyro_z",
+    "gesture": "label",
+}
+
+# Gesture names of 2_gesture_label.py -> track, same table as session_label_track()
+LABEL_TRACKS = {"rest": 0, "thumb_bent": 1, "index_bent": 2, "middle_bent": 3,
+                "ring_bent": 4, "pinky_bent": 5, "all_bent": 6}
+LABEL_UNKNOWN = -1
+
+SOURCE_LOG, SOURCE_CSV = 1, 2
+
+
+def _align(n):
+    return (n + ALIGN - 1) & ~(ALIGN - 1)
+
+
+def write_store(path, sessions):
+    """sessions: list of (name, source, {column: array}) with every column of COLUMNS"""
+    n_frames = sum(len(cols["t_ms"]) for _, _, cols in sessions)
+    dir_offset = HEADER_SIZE
+    offset = _align(dir_offset + len(COLUMNS) * struct.calcsize(COLUMN_FMT))
+    offsets = []
+    for _, dtype in COLUMNS:
+        offsets.append(offset)
+        offset = _align(offset + n_frames * np.dtype(dtype).itemsize)
+    index_offset = offset
+
+    tmp = path + ".tmp"
+    with open(tmp, "wb") as f:
+        f.write(struct.pack(HEADER_FMT, MAGIC, VERSION, HEADER_SIZE, len(COLUMNS), n_frames,
+                            len(sessions), dir_offset, index_offset).ljust(HEADER_SIZE, b"\0"))
+        for (name, dtype), off in zip(COLUMNS, offsets):
+            f.write(struct.pack(COLUMN_FMT, name.encode(), dtype.encode(), off, 0))
+        for (name, dtype), off in zip(COLUMNS, offsets):
+            f.seek(off)
+            for _, _, cols in sessions:
+                f.write(np.ascontiguousarray(cols[name], dtype=dtype).tobytes())
+        f.seek(index_offset)
+        first = 0
+        for name, source, cols in sessions:
+            count = len(cols["t_ms"])
+            f.write(struct.pack(INDEX_FMT, name.encode()[:63], first, count, source))
+            first += count
+    os.replace(tmp, path)   # readers never see a half-written store
+
+
+class SessionStore:
+    """Memory-mapped view of one .fses file; columns are numpy memmaps, nothing is parsed or copied"""
+
+    def __init__(self, path, mode="r"):
+        self.path = path
+        self._map = np.memmap(path, dtype=np.uint8, mode=mode)
+        magic, version, header_size, n_columns, self.n_frames, n_sessions, dir_offset, index_offset = \
+            struct.unpack_from(HEADER_FMT, self._map, 0)
+        if magic != MAGIC or version != VERSION or header_size != HEADER_SIZE:
+            raise ValueError(f"{path}: not a version {VERSION} session store")
+
+        self.columns = {}
+        for i in range(n_columns):
+            name, dtype, offset, _ = struct.unpack_from(COLUMN_FMT, self._map, dir_offset + i * struct.calcsize(COLUMN_FMT))
+            dtype = np.dtype(dtype.rstrip(b"\0").decode())
+            self.columns[name.rstrip(b"\0").decode()] = np.ndarray(
+                (self.n_frames,), dtype, buffer=self._map, offset=offset)
+
+        self.sessions = []
+        for i in range(n_sessions):
+            name, first, count, source = struct.unpack_from(INDEX_FMT, self._map, index_offset + i * struct.calcsize(INDEX_FMT))
+            self.sessions.append({"name": name.rstrip(b"\0").decode(), "first": first, "count": count, "source": source})
+
+    def __getitem__(self, column):
+        return self.columns[column]
+
+    def session(self, key):
+        """Column views of one session by index or name"""
+        s = self.sessions[key] if isinstance(key, int) else next(s for s in self.sessions if s["name"] == key)
+        return {name: col[s["first"]:s["first"] + s["count"]] for name, col in self.columns.items()}
+
+    def matrix(self, names):
+        """n_frames x len(names) float matrix, the only copy training needs"""
+        return np.column_stack([self.columns[n] for n in names]).astype(float)
+
+
+def store_paths(path):
+    """A .fses file or every .fses file in a folder, oldest first"""
+    if os.path.isdir(path):
+        return sorted(os.path.join(path, f) for f in os.listdir(path) if f.endswith(".fses"))
+    return [path]
+
+
+def open_stores(path):
+    return [SessionStore(p) for p in store_paths(path)]
+
+
+def load_matrix(path, names):
+    """Feature matrix over every store under path"""
+    stores = open_stores(path)
+    if not stores:
+        raise FileNotFoundError(f"No .fses session stores in {path}")
+    return np.concatenate([s.matrix(names) for s in stores]) if len(stores) > 1 else stores[0].matrix(names)
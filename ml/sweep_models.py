@@ -0,0 +1,188 @@
+import argparse, importlib, itertools, json, os, subprocess, tempfile, time
+from concurrent.futures import ProcessPoolExecutor
+import numpy as np
+from sklearn.preprocessing import StandardScaler
+from sklearn.cluster import KMeans
+import session_store as ss
+
+# Train every combination of cluster count, feature set, decision hold and flex filter,
+# replay each candidate blob through the firmware code (host/flexsonic_replay) on held-out
+# frames, and keep the best model on the accuracy / false-trigger / latency / cost front.
+#   python ingest_sessions.py "../data processed/gesture_labeled.csv" --out ../sessions/labelled.fses
+#   python sweep_models.py --store ../sessions/labelled.fses --jobs 8
+
+export = importlib.import_module("5_export_model_blob")
+
+FEATURES = {"flex": ss.FLEX, "flex_gyro": ss.FLEX + ss.GYRO}
+OBJECTIVES = [("accuracy", 1), ("false_trigger_rate", -1), ("decision_ms", -1), ("frame_cost", -1)]
+RAW_FRAMES = 128  # ADC frames filtered into one 300 ms recognition frame (governor READY level)
+
+
+def frame_cost(cand):
+    """Firmware work per recognition frame: filter taps over the raw frames plus centroid distances.
+    Counted rather than timed, so the sweep picks the same model on any host and any --jobs"""
+    median_n, iir_shift, _ = cand["filter"]
+    taps = median_n + (1 if iir_shift else 0)
+    return len(ss.FLEX) * RAW_FRAMES * taps + cand["k"] * len(FEATURES[cand["features"]])
+
+
+def split_sessions(stores, train_frac):
+    """Chronological split of every labelled session: head trains, tail is replayed"""
+    train, held_out = [], []
+    for store in stores:
+        for i, s in enumerate(store.sessions):
+            cols = {name: np.asarray(col) for name, col in store.session(i).items()}
+            if not np.any(cols["label"] != ss.LABEL_UNKNOWN):
+                continue
+            cut = int(len(cols["t_ms"]) * train_frac)
+            train.append({c: v[:cut] for c, v in cols.items()})
+            held_out.append((s["name"], s["source"], {c: v[cut:] for c, v in cols.items()}))
+    if not train:
+        raise SystemExit("❌ No labelled sessions, ingest a labelled CSV first")
+    return {c: np.concatenate([t[c] for t in train]) for c in train[0]}, held_out
+
+
+def fit_model(train, features, k, radius_pct):
+    """Scaler + KMeans on moving hands, clusters mapped to tracks by majority label"""
+    moving = np.column_stack([train[c] for c in ss.FLEX]).sum(axis=1) > 0
+    X = np.column_stack([train[c] for c in FEATURES[features]]).astype(float)[moving]
+    labels = train["label"][moving]
+
+    scaler = StandardScaler()
+    Xs = scaler.fit_transform(X)
+    kmeans = KMeans(n_clusters=k, random_state=42, n_init=10).fit(Xs)
+
+    mapping, radii = {}, []
+    dist = np.linalg.norm(Xs - kmeans.cluster_centers_[kmeans.labels_], axis=1)
+    for c in range(k):
+        members = kmeans.labels_ == c
+        known = labels[members & (labels != ss.LABEL_UNKNOWN)]
+        mapping[c] = int(np.bincount(known).argmax()) if len(known) else 0
+        radii.append(float(np.percentile(dist[members], radius_pct)) if members.any() else 0.0)
+    return scaler, kmeans, mapping, radii
+
+
+def evaluate(task):
+    """Build one candidate blob and replay it; returns the candidate with its scores"""
+    cand, train, args = task
+    median_n, iir_shift, decimation = cand["filter"]
+    scaler, kmeans, mapping, radii = fit_model(train, cand["features"], cand["k"], args.radius_pct)
+    blob = export.build_blob([], scaler, kmeans, mapping, args.generation, radii=radii, pipeline={
+        "hold": cand["window"], "median_n": median_n, "iir_shift": iir_shift, "decimation": decimation})
+
+    blob_path = os.path.join(args.workdir, f"{cand['id']}.bin")
+    json_path = os.path.join(args.workdir, f"{cand['id']}.json")
+    with open(blob_path, "wb") as f:
+        f.write(blob)
+    cmd = [args.replay, "--model", blob_path, "--session", args.eval_store, "--json", json_path]
+    if args.synthetic_frames:
+        cmd += ["--session", "synthetic", "--synthetic-frames", str(args.synthetic_frames)]
+    subprocess.run(cmd, check=True, capture_output=True)
+    with open(json_path) as f:
+        sessions = json.load(f)["sessions"]
+
+    labelled = sum(s["labelled"] for s in sessions)
+    scored = sum(s["scored_plays"] for s in sessions)
+    detected = sum(s["detected"] for s in sessions)
+    cand.update({
+        "accuracy": sum(s["accuracy"] * s["labelled"] for s in sessions) / labelled if labelled else 0.0,
+        "false_trigger_rate": sum(s["false_plays"] for s in sessions) / scored if scored else 0.0,
+        "detection_rate": detected / max(1, sum(s["segments"] for s in sessions)),
+        "decision_ms": sum(s["decision_ms"] * s["detected"] for s in sessions) / detected if detected else None,
+        "frame_cost": frame_cost(cand),
+        "frame_ns": max(s["frame_ns"]["p50"] for s in sessions),  # report only, varies with host load
+        "blob_bytes": len(blob),
+        "clusters": {str(c): t for c, t in mapping.items()},
+    })
+    return cand, blob
+
+
+def objective(c, key):
+    """decision_ms is None (never decided) in the report, the worst latency here"""
+    return float("inf") if c[key] is None else c[key]
+
+
+def dominates(a, b):
+    better = [sign * (objective(a, key) - objective(b, key)) for key, sign in OBJECTIVES]
+    return all(d >= 0 for d in better) and any(d > 0 for d in better)
+
+
+def pareto_front(cands):
+    return [c for c in cands if not any(dominates(o, c) for o in cands if o is not c)]
+
+
+def choose(front, max_false):
+    """Most accurate front member within the false-trigger budget, else the fewest false plays"""
+    ok = [c for c in front if c["false_trigger_rate"] <= max_false]
+    if ok:
+        return max(ok, key=lambda c: (c["accuracy"], -objective(c, "decision_ms"), -c["frame_cost"], -c["blob_bytes"]))
+    return min(front, key=lambda c: (c["false_trigger_rate"], -c["accuracy"]))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--store", default=os.path.join("..", "sessions"), help="Labelled .fses store or a folder of stores")
+    parser.add_argument("--k", type=int, nargs="+", default=[4, 5, 6, 7, 8])
+    parser.add_argument("--features", nargs="+", default=list(FEATURES), choices=list(FEATURES))
+    parser.add_argument("--window", type=int, nargs="+", default=[1, 2, 3], help="Decision hold, frames in a row")
+    parser.add_argument("--filter", nargs="+", default=["5,2,4", "3,2,4", "3,1,2", "1,0,1"],
+                        help="median_n,iir_shift,decimation of the flex filter bank")
+    parser.add_argument("--train_frac", type=float, default=0.7, help="Head of each session used for training")
+    parser.add_argument("--radius_pct", type=float, default=99.0)
+    parser.add_argument("--max_false", type=float, default=0.05, help="False-trigger budget of the chosen model")
+    parser.add_argument("--synthetic_frames", type=int, default=0,
+                        help="Also replay a synthetic session of N frames (stress test, outweighs small stores)")
+    parser.add_argument("--replay", default=os.path.join("..", "host", "build", "flexsonic_replay"))
+    parser.add_argument("--jobs", type=int, default=os.cpu_count())
+    parser.add_argument("--out", default=os.path.join("..", "models", "model.bin"))
+    parser.add_argument("--report", default=os.path.join("..", "models", "sweep.json"))
+    parser.add_argument("--slot", default="auto", choices=("auto",) + export.SLOTS,
+                        help="Slot to flash; auto reads both slots and picks the inactive one")
+    parser.add_argument("--generation", type=int,
+                        help="Higher generation wins at boot; default one above both slots")
+    parser.add_argument("--port", help="Serial port of the glove, for parttool.py")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.replay):
+        raise SystemExit(f"❌ {args.replay} missing: cmake -S host -B host/build && cmake --build host/build")
+    # Before the sweep, so a glove that cannot be read fails fast
+    args.slot, args.generation = export.deploy_target(args.slot, args.generation, args.port)
+    start = time.time()
+    train, held_out = split_sessions(ss.open_stores(args.store), args.train_frac)
+
+    cands = []
+    for k, feat, window, filt in itertools.product(args.k, args.features, args.window, args.filter):
+        cands.append({"id": len(cands), "k": k, "features": feat, "window": window,
+                      "filter": [int(v) for v in filt.split(",")]})
+
+    # sklearn and the replay binary each get one core, the pool spreads candidates over all of them
+    os.environ["OMP_NUM_THREADS"] = "1"
+    with tempfile.TemporaryDirectory() as workdir:
+        args.workdir = workdir
+        args.eval_store = os.path.join(workdir, "held_out.fses")
+        ss.write_store(args.eval_store, held_out)
+        with ProcessPoolExecutor(args.jobs) as pool:
+            results = list(pool.map(evaluate, [(c, train, args) for c in cands]))
+
+    scored = [c for c, _ in results]
+    front = pareto_front(scored)
+    best = choose(front, args.max_false)
+    blob = results[best["id"]][1]
+
+    print(f"{'k':>3} {'features':<10}{'hold':>5} {'filter':<8}{'acc':>7}{'false':>7}{'dec ms':>8}{'cost':>7}{'bytes':>7}")
+    for c in sorted(front, key=lambda c: -c["accuracy"]):
+        mark = " ⭐" if c is best else ""
+        print(f"{c['k']:>3} {c['features']:<10}{c['window']:>5} {','.join(map(str, c['filter'])):<8}"
+              f"{c['accuracy']:>7.3f}{c['false_trigger_rate']:>7.3f}{objective(c, 'decision_ms'):>8.0f}"
+              f"{c['frame_cost']:>7}{c['blob_bytes']:>7}{mark}")
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.out)), exist_ok=True)
+    with open(args.out, "wb") as f:
+        f.write(blob)
+    with open(args.report, "w") as f:
+        json.dump({"chosen": best, "front": [c["id"] for c in front], "candidates": scored,
+                   "held_out_frames": sum(len(c["t_ms"]) for _, _, c in held_out)}, f, indent=2)
+    print(f"💾 {len(cands)} candidates, {len(front)} on the front ({time.time() - start:.1f} s, {args.jobs} jobs)")
+    print(f"💾 Wrote {args.out} ({len(blob)} bytes, gen {args.generation}) and {args.report}")
+    print(f"Flash it into {args.slot}; it takes over at the next boot:")
+    export.print_flash_command(args.out, args.slot, args.port)